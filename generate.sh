@@ -1,2 +1,4 @@
 cd generation
 python luts.py
+python crc.py
+python params.py
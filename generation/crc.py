@@ -0,0 +1,52 @@
+from pathlib import Path
+
+# crc16/x-25 (the uart packet crc): reflected poly 0x1021, init 0xffff, final xor 0xffff
+
+dest_path = Path("../src/comms/generated")
+dest_path.mkdir(parents=False, exist_ok=True)
+
+CRC16_POLY_REFLECTED = 0x8408
+LITERALS_PER_LINE = 8
+
+def crc16_byte(x):
+    crc = x
+    for _ in range(8):
+        crc = (crc >> 1) ^ CRC16_POLY_REFLECTED if crc & 1 else crc >> 1
+    return crc
+
+table = [crc16_byte(x) for x in range(256)]
+
+# the crc over a message followed by its own (little endian, complemented) crc is a constant
+def crc16(data):
+    crc = 0xFFFF
+    for x in data:
+        crc = (crc >> 8) ^ table[(crc ^ x) & 0xFF]
+    return crc
+
+message = b"123456789"
+check = crc16(message) ^ 0xFFFF
+assert check == 0x906E, "x-25 check value"
+residue = crc16(message + bytes([check & 0xFF, check >> 8]))
+
+
+# ======== FILE GENERATION =========
+file_lines = [
+    "#pragma once",
+    "// generated by generation/crc.py",
+    "#include <stdint.h>",
+    '#include "esp_attr.h"',
+    "",
+    f"#define CRC16_RESIDUE 0x{residue:04X}    // crc over a whole packet, its crc included, before the final xor",
+    "",
+    "DRAM_ATTR static const uint16_t crc16_table[256] = {",
+]
+
+for i in range(0, len(table), LITERALS_PER_LINE):
+    file_lines.append("    " + ", ".join(f"0x{x:04X}" for x in table[i:i + LITERALS_PER_LINE]) + ",")
+
+file_lines.append("};")
+
+with open(dest_path / "crc16.hpp", 'w') as f:
+    f.writelines([x + '\n' for x in file_lines])
+
+print(f"generated file! (residue 0x{residue:04X})")
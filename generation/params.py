@@ -0,0 +1,238 @@
+from pathlib import Path
+
+# single source of the synth parameters: ui widgets, ids (storage and remote) and midi cc numbers.
+# run from this folder (generate.sh does), then map the new widget into its tab in apply_tab (UiController.cpp).
+# the knob ranges, curves and formats and the selector options live here too, see KNOBS and SELECTORS
+
+dest_path = Path("../src/ui/generated")
+dest_path.mkdir(parents=False, exist_ok=True)
+
+# tab order is the id order, names are drawn in the header
+TABS = [
+    ("Input",    "arp"),
+    ("Osc1",     "o1"),
+    ("Osc2",     "o2"),
+    ("Osc3",     "o3"),
+    ("Envelope", "env"),
+    ("Filter",   "flt"),
+    ("Effects",  "fx"),
+]
+
+# widget configs the schema refers to by name.
+# knobs: min, max, curve, format, default value. log curves need min > 0
+KNOBS = {
+    "level_config":   (0.0,   1.0,     "Linear", "format_ratio", 0.5),
+    "mix_config":     (0.0,   1.0,     "Linear", "format_ratio", 0.0),
+    "detune_config":  (-50.0, 50.0,    "Linear", "format_cents", 0.0),
+    "pan_config":     (-1.0,  1.0,     "Linear", "format_pan",   0.0),
+    "time_config":    (0.01,  60.0,    "Log",    "format_secs",  1.0),
+    "cutoff_config":  (50.0,  18000.0, "Log",    "format_hz",    10000.0),
+    "contour_config": (0.0,   4000.0,  "Linear", "format_hz",    0.0),
+}
+
+# selectors: (label, value) options, the divisor get_value_asf32 applies and the default label.
+# values are emitted as written, so enum names work too
+SELECTORS = {
+    "division_config": dict(norm=1, default="1", options=[
+        ("1", 1), ("1/2", 2), ("1/4", 4), ("1/8", 8)]),
+    "tempo_config": dict(norm=1, default="120", options=[
+        ("80", 80), ("100", 100), ("120", 120), ("130", 130), ("150", 150)]),
+    "shape_config": dict(norm=1, default="tri", options=[
+        ("tri", "WaveIndex::Tri"), ("t_s", "WaveIndex::TriSaw"), ("saw", "WaveIndex::Saw"),
+        ("squ", "WaveIndex::Square"), ("re1", "WaveIndex::RectWide"), ("re2", "WaveIndex::RectNarrow")]),
+    "range_config": dict(norm=8, default="8'", options=[
+        ("32'", 32), ("16'", 16), ("8'", 8), ("4'", 4), ("2'", 2)]),
+    "boost_config": dict(norm=10, default="+0", options=[
+        ("+0", 10), ("+1", 15), ("+2", 20)]),
+    "beats_config": dict(norm=100, default="1/8", options=[
+        ("1/16", 25), ("1/8", 50), ("3/16", 75), ("1/4", 100), ("3/8", 150), ("1/2", 200)]),
+}
+
+# cc numbers follow the general midi sound controllers where one fits, 16-19 and 80-83 otherwise
+CC_NONE = None
+
+def switch(name, key, cc=CC_NONE, default=None):
+    return dict(name=name, kind="Switch", key=key, config=None, cc=cc, default=default)
+
+def selector(name, key, config, cc=CC_NONE, default=None):
+    return dict(name=name, kind="Selector", key=key, config=config, cc=cc, default=default)
+
+def knob(name, key, config, cc=CC_NONE, default=None):
+    return dict(name=name, kind="Knob", key=key, config=config, cc=cc, default=default)
+
+def osc(n, gain_cc, detune_cc):
+    return [
+        selector(f"osc{n}_range",  "octv", "range_config"),
+        knob    (f"osc{n}_detune", "tune", "detune_config", cc=detune_cc),
+        selector(f"osc{n}_shape",  "shp",  "shape_config"),
+        knob    (f"osc{n}_pan",    "pan",  "pan_config"),
+        knob    (f"osc{n}_gain",   "gain", "level_config", cc=gain_cc),
+        switch  (f"osc{n}_enabled", "en", default="true" if n == 1 else None),
+    ]
+
+# one list per tab, the position is the slot: 0-2 first row, 3-5 shifted row, None leaves it empty
+SCHEMA = {
+    "Input": [
+        switch  ("arp_enabled",  "en"),
+        selector("arp_division", "div", "division_config"),
+        selector("arp_tempo",    "bpm", "tempo_config"),
+    ],
+    "Osc1": osc(1, 16, 80),
+    "Osc2": osc(2, 17, 81),
+    "Osc3": osc(3, 18, 82),
+    "Envelope": [
+        knob    ("env_attack",  "att", "time_config",  cc=73),
+        knob    ("env_decay",   "dec", "time_config",  cc=75),
+        knob    ("env_sustain", "sus", "level_config", cc=70),
+        None,
+        selector("env_boost",   "bst",  "boost_config"),
+        knob    ("env_gain",    "gain", "level_config", cc=7, default="1.f"),
+    ],
+    "Filter": [
+        knob    ("flt_cutoff",    "cut", "cutoff_config",  cc=74),
+        knob    ("flt_resonance", "res", "level_config",   cc=71, default="0.3f"),
+        knob    ("flt_contour",   "cou", "contour_config", cc=76),
+        knob    ("flt_attack",    "att", "time_config"),
+        knob    ("flt_decay",     "dec", "time_config"),
+        knob    ("flt_sustain",   "sus", "level_config"),
+    ],
+    "Effects": [
+        knob    ("fx_delay",    "dly",  "mix_config",   cc=94),
+        knob    ("fx_feedback", "fb",   "level_config"),
+        selector("fx_beats",    "time", "beats_config"),
+        knob    ("fx_chorus",   "cho",  "mix_config",   cc=93),
+        knob    ("fx_reverb",   "rev",  "mix_config",   cc=91),
+        knob    ("fx_size",     "size", "level_config", cc=19),
+    ],
+}
+
+
+def camel(name):
+    return "".join(part.capitalize() for part in name.split("_"))
+
+params = []
+for tab_index, (tab, _) in enumerate(TABS):
+    for slot, param in enumerate(SCHEMA[tab]):
+        if param is not None:
+            params.append(dict(param, tab=tab_index, slot=slot))
+
+for p in params:
+    if p["kind"] == "Knob":     assert p["config"] in KNOBS, f"{p['name']}: unknown knob config"
+    if p["kind"] == "Selector": assert p["config"] in SELECTORS, f"{p['name']}: unknown selector config"
+for name, (lo, hi, curve, _, default) in KNOBS.items():
+    assert lo < hi and lo <= default <= hi, f"{name}: bad range"
+    assert curve != "Log" or lo > 0, f"{name}: log curve needs min > 0"
+for name, sel in SELECTORS.items():
+    assert sel["default"] in [label for label, _ in sel["options"]], f"{name}: default is not an option"
+
+ccs = [p["cc"] for p in params if p["cc"] is not None]
+assert len(ccs) == len(set(ccs)), "cc mapped twice"
+assert all(len(SCHEMA[tab]) <= 6 for tab, _ in TABS), "6 slots per tab"
+assert len(params) <= 64, "UiController keeps change masks in 64 bits"
+
+
+# ======== FILE GENERATION =========
+header = [
+    "#pragma once",
+    "// generated by generation/params.py, edit the schema there",
+]
+
+# ids, specs and tabs: usable anywhere
+file_lines = header + [
+    "#include <cinttypes>",
+    "",
+    "namespace Tab {",
+    "    enum Value {",
+] + [f"        {tab}," for tab, _ in TABS] + [
+    "    };",
+    "};",
+    "",
+    "constexpr const char* tab_names[] = {",
+    "    " + ", ".join(f'"{name}"' for _, name in TABS),
+    "};",
+    "",
+    f"const uint8_t TAB_COUNT = {len(TABS)};",
+    "",
+    "/** dense parameter index, the position in every flat parameter array */",
+    "namespace ParamIndex {",
+    "    enum Value {",
+] + [f"        {camel(p['name'])}," for p in params] + [
+    "        Count,",
+    "    };",
+    "};",
+    "",
+    "#define PARAM_CC_NONE 0xFF",
+    "",
+    "struct ParamSpec {",
+    "    uint8_t tab;",
+    "    uint8_t slot;",
+    "    uint8_t cc;     // midi control change number, PARAM_CC_NONE when unmapped",
+    "};",
+    "",
+    "constexpr ParamSpec PARAM_SPECS[ParamIndex::Count] = {",
+] + [
+    f"    {{ {p['tab']}, {p['slot']}, {p['cc'] if p['cc'] is not None else 'PARAM_CC_NONE'} }},".ljust(36) + f"// {camel(p['name'])}"
+    for p in params
+] + [
+    "};",
+]
+
+with open(dest_path / "params.hpp", 'w') as f:
+    f.writelines([x + '\n' for x in file_lines])
+print(f"generated {len(params)} params!")
+
+
+# widgets and their configs: only UiController.cpp
+def cfloat(x):
+    text = repr(float(x))
+    return (text[:-1] if text.endswith(".0") else text) + "f"
+
+width = max(len(p["name"]) for p in params)
+widget_lines = header + [
+    "// included by UiController.cpp, after widget.hpp and wavetable.hpp (shape values)",
+    '#include "params.hpp"',
+    "",
+    "// ---------- KNOBS ----------",
+]
+
+knob_width = max(len(name) for name in KNOBS)
+for name, (lo, hi, curve, fmt, default) in KNOBS.items():
+    fields = [cfloat(lo), cfloat(hi), f"Curve::{curve}", fmt, cfloat(default)]
+    widget_lines.append(f"static const KnobConfig {name.ljust(knob_width)} = {{ {', '.join(fields)} }};")
+
+widget_lines += ["", "// ---------- SELECTORS ----------"]
+for name, sel in SELECTORS.items():
+    base = name[:-len("_config")]
+    labels = [label for label, _ in sel["options"]]
+    quoted = ", ".join(f'"{label}"' for label in labels)
+    widget_lines += [
+        f"static const char* {base}_labels[] = {{ {quoted} }};",
+        f"static int32_t {base}_values[] = {{ {', '.join(str(value) for _, value in sel['options'])} }};",
+        f"static const SelectorConfig {name} = {{",
+        f"    .display_values = {base}_labels,",
+        f"    .values         = {base}_values,",
+        f"    .norm_factor    = {sel['norm']},",
+        f"    .count          = {len(labels)},",
+        f"    .default_index  = {labels.index(sel['default'])}   // " + f'"{sel["default"]}"',
+        "};",
+        "",
+    ]
+
+widget_lines += ["// ---------- WIDGETS ----------"]
+
+for p in params:
+    args = [f'"{p["key"]}"']
+    if p["config"]: args.append(p["config"])
+    if p["default"]: args.append(p["default"])
+    widget_lines.append(f"static {p['kind'].ljust(8)} {p['name'].ljust(width)} = {p['kind'].ljust(8)}({', '.join(args)});")
+
+widget_lines += [
+    "",
+    "static Widget *const param_widgets[ParamIndex::Count] = {",
+] + [f"    &{p['name']}," for p in params] + [
+    "};",
+]
+
+with open(dest_path / "param_widgets.hpp", 'w') as f:
+    f.writelines([x + '\n' for x in widget_lines])
+print("generated widgets!")
@@ -7,14 +7,63 @@
 #define PIN_LED 2
 #define PIN_I2C_SDA 21
 #define PIN_I2C_SCK 22
+#define DISPLAY_I2C_ADDR 0x3C   // ssd1306 128x64
+#define DISPLAY_I2C_CLOCK_HZ 800000  // above the 400k datasheet figure, ssd1306 modules run fine up to ~1mhz
 
 // COMMS
-#define UART_RX_BUFFER_SIZE     128
-#define MIDI_EVENTS_QUEUE_SIZE  128
+#ifndef UART_BAUD_RATE
+#define UART_BAUD_RATE          115200  // the sender must match, 1mbaud is a build flag (platformio.ini)
+#endif
+#define UART_RX_BUFFER_SIZE     256     // bytes decoded per read
+#define UART_RX_RING_SIZE       2048    // driver ring buffer, ~180ms at 115200, ~20ms at 1mbaud
+#define UART_EVENT_QUEUE_SIZE   16
+#define LOG_SINK_BUFFER_SIZE    2048    // peer log lines waiting for the console
+#define LOG_SINK_RATE_PER_SEC   50
+#define LOG_SINK_RATE_BURST     20
+#define LOG_SINK_LOST_REPORT_MS 500     // lost lines are reported at the latest after this much silence
+#define MIDI_EVENTS_QUEUE_SIZE  128     // per producer ring, power of two
 #define INPUT_EVENTS_QUEUE_SIZE 64
+#define PARAM_REQUEST_MAX       512     // one ble write at the max mtu
+#define PARAM_QUEUE_SIZE        4
+#define MIDI_CONTROL_QUEUE_SIZE 32     // program and control changes, knob sweeps send many
 #define BLE_NAME "ESP-Synth"
+#define BLE_MAX_MTU             517
+#define BLE_MAX_TX_OCTETS       251     // data length extension, one link layer packet per att mtu chunk
+#define BLE_CONN_INTERVAL_MIN   6       // 1.25ms units, 7.5ms is the ble-midi recommendation
+#define BLE_CONN_INTERVAL_MAX   12
+#define BLE_MIDI_JITTER_MS      10      // fixed delay that absorbs the connection interval batching
+#define BLE_MIDI_MAX_EVENTS     32      // channel messages kept from one packet
+#define SCREEN_MIN_INTERVAL_MS  20      // fastest screen stream rate, the ui frame rate
+#define SCREEN_MAX_INTERVAL_MS  500
 #define SCREEN_BUFFER_SIZE (128 * 64 / 8)
 
+// PATCHES
+#define PATCH_SLOTS                 8
+#define PATCH_SAVE_DEBOUNCE_MS      3000    // quiet time after the last change before autosaving
+#define PATCH_SAVE_MIN_INTERVAL_MS  20000   // nvs wear: at most one autosave every 20s
+#define PRESET_MORPH_SECS           0.5f    // glide time on a midi program change, 0 switches at once
+
+// MEMORY
+#define RUNTIME_ARENA_SIZE (1 * 1024)   // task buffers, taken once at task start
+
+// TASKS
+#define TASK_STACK_UART_RX  4096
+#define TASK_STACK_DISPLAY  4096
+#define TASK_STACK_FLUSH    2048
+#define TASK_STACK_SCREEN   3072
+#define TASK_STACK_I2S      4096
+#define TASK_STACK_MONITOR  3072
+#define TASK_STACK_LOG      2048
+#define MONITOR_PERIOD_MS   2000
+
 // SYNTH
 #define SYNTH_CHUNK_SIZE    ((size_t)128)
 #define SYNTH_SR            44100
+
+// EFFECTS
+#define FX_ARENA_INTERNAL_SIZE  (72 * 1024)
+#define FX_ARENA_PSRAM_SIZE     (512 * 1024)
+#define FX_PSRAM_MIN_ALLOC      (8 * 1024)  // smaller buffers stay in internal ram
+#define FX_DELAY_MAX_SECS       0.3f        // without psram
+#define FX_DELAY_MAX_SECS_PSRAM 2.0f
+#define FX_CLEAR_FRAMES         1024        // per line and block, a disabled effect clears its lines in slices
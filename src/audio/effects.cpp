@@ -0,0 +1,281 @@
+#include "effects.hpp"
+#include <cstring>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include "wavetable.hpp"
+
+static const char *FX_TAG = "EFFECTS";
+
+// ------- ARENA --------
+static uint8_t s_internal_arena[FX_ARENA_INTERNAL_SIZE];
+
+void FxArena::begin() {
+    internal = Arena(s_internal_arena, FX_ARENA_INTERNAL_SIZE);
+
+    if(heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM) >= FX_ARENA_PSRAM_SIZE) {
+        psram = Arena((uint8_t*) heap_caps_malloc(FX_ARENA_PSRAM_SIZE, MALLOC_CAP_SPIRAM), FX_ARENA_PSRAM_SIZE);
+    }
+}
+
+void *FxArena::alloc(size_t bytes) {
+    void *ptr = nullptr;
+
+    if(psram.valid() && bytes >= FX_PSRAM_MIN_ALLOC)
+        ptr = psram.alloc(bytes);
+
+    if(!ptr)
+        ptr = internal.alloc(bytes);
+
+    if(!ptr)
+        ESP_LOGE(FX_TAG, "arena exhausted (request: %d, internal used: %d)", bytes, internal.used());
+
+    return ptr;
+}
+
+
+// ------- DELAY LINE --------
+bool DelayLine::begin(FxArena &arena, size_t frames) {
+    buffer = (int16_t*) arena.alloc(frames * sizeof(int16_t));
+    len = buffer ? frames : 0;
+    clear();
+    return buffer != nullptr;
+}
+
+void DelayLine::clear() {
+    if(buffer) memset(buffer, 0, len * sizeof(int16_t));
+    pos = 0;
+}
+
+void DelayLine::clear_range(size_t from, size_t frames) {
+    if(!buffer || from >= len) return;
+    const size_t n = len - from < frames ? len - from : frames;
+    memset(buffer + from, 0, n * sizeof(int16_t));
+}
+
+
+// ------- EFFECT --------
+#define FX_PROFILE_BLOCKS 1000
+
+void Effect::step(StereoSample *data, size_t len) {
+    if(!enabled()) _running = false;
+
+    // a whole line at once would stall the i2s block, old samples go a slice per block instead
+    if(!_running && _dirty) {
+        if(clear_slice(clear_from, FX_CLEAR_FRAMES)) {
+            _dirty = false;
+            clear_from = 0;
+        }
+        else clear_from += FX_CLEAR_FRAMES;
+        return;
+    }
+
+    if(!enabled()) return;
+    _running = true;
+    _dirty = true;
+
+#ifdef FX_PROFILE
+    const int64_t start = esp_timer_get_time();
+    process_block(data, len);
+    profile(esp_timer_get_time() - start);
+#else
+    process_block(data, len);
+#endif
+}
+
+void Effect::profile(uint32_t elapsed_us) {
+    worst_us = elapsed_us > worst_us ? elapsed_us : worst_us;
+
+    if(++profiled_blocks % FX_PROFILE_BLOCKS == 0) {
+        if(worst_us > budget_us) ESP_LOGW(FX_TAG, "[%s]> %dus, over budget (%dus)", name, worst_us, budget_us);
+        else                     ESP_LOGI(FX_TAG, "[%s]> %dus (budget %dus)", name, worst_us, budget_us);
+        worst_us = 0;
+    }
+}
+
+
+// ------- DELAY --------
+bool StereoDelay::begin(FxArena &arena) {
+    const float max_secs = arena.has_psram() ? FX_DELAY_MAX_SECS_PSRAM : FX_DELAY_MAX_SECS;
+    const size_t frames = max_secs * SYNTH_SR;
+
+    _ready = line_left.begin(arena, frames) && line_right.begin(arena, frames);
+    return _ready;
+}
+
+void StereoDelay::configure(const EffectsConfig &config, float tempo_bpm) {
+    enable(config.delay.mix > 0.f);
+    if(!_ready) return;
+
+    mix = config.delay.mix;
+    feedback = config.delay.feedback < 0.95f ? config.delay.feedback : 0.95f;
+
+    // longer times than the line are clamped
+    const size_t frames = 60.f / tempo_bpm * config.delay.beats * SYNTH_SR;
+    delay_frames = constrain(frames, (size_t)1, line_left.len);
+}
+
+bool StereoDelay::clear_slice(size_t from, size_t frames) {
+    line_left.clear_range(from, frames);
+    line_right.clear_range(from, frames);
+    return from + frames >= line_left.len;
+}
+
+void StereoDelay::process_block(StereoSample *data, size_t len) {
+    for(size_t i = 0; i < len; i++) {
+        const float wet_left  = line_left.read(delay_frames);
+        const float wet_right = line_right.read(delay_frames);
+
+        line_left.write(data[i].left   + wet_right * feedback);
+        line_right.write(data[i].right + wet_left  * feedback);
+
+        data[i].left  += wet_left  * mix;
+        data[i].right += wet_right * mix;
+    }
+}
+
+
+// ------- CHORUS --------
+#define CHORUS_LINE_FRAMES  1024
+#define CHORUS_RATE_HZ      0.8f
+#define CHORUS_BASE_FRAMES  (0.007f * SYNTH_SR)
+#define CHORUS_DEPTH_FRAMES (0.003f * SYNTH_SR)
+
+bool StereoChorus::begin(FxArena &arena) {
+    _ready = line_left.begin(arena, CHORUS_LINE_FRAMES) && line_right.begin(arena, CHORUS_LINE_FRAMES);
+    return _ready;
+}
+
+void StereoChorus::configure(const EffectsConfig &config, float tempo_bpm) {
+    enable(config.chorus.mix > 0.f);
+    if(!_ready) return;
+
+    mix = config.chorus.mix * 0.5f; // full mix is half dry, half wet
+}
+
+bool StereoChorus::clear_slice(size_t from, size_t frames) {
+    line_left.clear_range(from, frames);
+    line_right.clear_range(from, frames);
+    return from + frames >= CHORUS_LINE_FRAMES;
+}
+
+void StereoChorus::process_block(StereoSample *data, size_t len) {
+    static const float lfo_dt = CHORUS_RATE_HZ / SYNTH_SR;
+
+    for(size_t i = 0; i < len; i++) {
+        lfo_phase += lfo_dt;
+        if(lfo_phase >= 1.f) lfo_phase -= 1.f;
+
+        line_left.write(data[i].left);
+        line_right.write(data[i].right);
+
+        const float wet_left  = line_left.read_frac(CHORUS_BASE_FRAMES  + CHORUS_DEPTH_FRAMES * wave_sin(lfo_phase));
+        const float wet_right = line_right.read_frac(CHORUS_BASE_FRAMES + CHORUS_DEPTH_FRAMES * wave_sin(lfo_phase + 0.25f));
+
+        data[i].left  += (wet_left  - data[i].left)  * mix;
+        data[i].right += (wet_right - data[i].right) * mix;
+    }
+}
+
+
+// ------- REVERB --------
+static const size_t REVERB_COMB_FRAMES[LiteReverb::COMB_COUNT] = { 558, 594, 638, 678 };
+static const size_t REVERB_ALLPASS_FRAMES[LiteReverb::ALLPASS_COUNT] = { 278, 220 };
+static const size_t REVERB_STEREO_SPREAD = 23;
+
+#define REVERB_INPUT_GAIN 0.03f
+#define REVERB_WET_GAIN   3.f
+
+bool LiteReverb::begin(FxArena &arena) {
+    _ready = true;
+
+    for(size_t c = 0; c < 2; c++) {
+        const size_t spread = c * REVERB_STEREO_SPREAD;
+
+        for(size_t i = 0; i < COMB_COUNT; i++)
+            _ready &= channels[c].combs[i].line.begin(arena, REVERB_COMB_FRAMES[i] + spread);
+
+        for(size_t i = 0; i < ALLPASS_COUNT; i++)
+            _ready &= channels[c].allpasses[i].begin(arena, REVERB_ALLPASS_FRAMES[i] + spread);
+    }
+
+    return _ready;
+}
+
+void LiteReverb::configure(const EffectsConfig &config, float tempo_bpm) {
+    enable(config.reverb.mix > 0.f);
+    if(!_ready) return;
+
+    mix = config.reverb.mix;
+    feedback = 0.7f + config.reverb.size * 0.25f;
+}
+
+bool LiteReverb::clear_slice(size_t from, size_t frames) {
+    size_t longest = 0;
+
+    for(auto &ch : channels) {
+        for(auto &comb : ch.combs) {
+            comb.line.clear_range(from, frames);
+            comb.filter_state = 0.f;
+            longest = comb.line.len > longest ? comb.line.len : longest;
+        }
+        for(auto &allpass : ch.allpasses) allpass.clear_range(from, frames);
+    }
+
+    return from + frames >= longest;
+}
+
+FORCE_INLINE float LiteReverb::process_channel(Channel &ch, float input, float feedback, float damping) {
+    float out = 0.f;
+
+    for(auto &comb : ch.combs) {
+        const float y = comb.line.read(comb.line.len);
+        comb.filter_state = y * (1.f - damping) + comb.filter_state * damping;
+        comb.line.write(input + comb.filter_state * feedback);
+        out += y;
+    }
+
+    for(auto &allpass : ch.allpasses) {
+        const float y = allpass.read(allpass.len);
+        allpass.write(out + y * 0.5f);
+        out = y - out;
+    }
+
+    return out;
+}
+
+void LiteReverb::process_block(StereoSample *data, size_t len) {
+    const float dry = 1.f - mix * 0.5f;
+    const float wet = mix * REVERB_WET_GAIN;
+
+    for(size_t i = 0; i < len; i++) {
+        const float input = (data[i].left + data[i].right) * REVERB_INPUT_GAIN;
+
+        const float wet_left  = process_channel(channels[0], input, feedback, damping);
+        const float wet_right = process_channel(channels[1], input, feedback, damping);
+
+        data[i].left  = data[i].left  * dry + wet_left  * wet;
+        data[i].right = data[i].right * dry + wet_right * wet;
+    }
+}
+
+
+// ------- CHAIN --------
+void EffectsChain::begin() {
+    arena.begin();
+
+    for(auto effect : effects) {
+        if(!effect->begin(arena))
+            ESP_LOGE(FX_TAG, "%s: not enough memory, disabled", effect->name);
+    }
+}
+
+void EffectsChain::configure(const EffectsConfig &config, float tempo_bpm, bool hold) {
+    for(auto effect : effects) {
+        effect->hold(hold);
+        effect->configure(config, tempo_bpm);
+    }
+}
+
+void EffectsChain::process_block(StereoSample *data, size_t len) {
+    for(auto effect : effects) effect->step(data, len);
+}
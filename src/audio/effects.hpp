@@ -0,0 +1,215 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "config.h"
+#include "perf.h"
+#include "stereo.hpp"
+#include "memory/arena.hpp"
+
+// ------- ARENA --------
+/** big requests go to psram when the board has it, everything else stays in internal ram */
+class FxArena {
+public:
+    void begin();
+    void *alloc(size_t bytes);
+    bool has_psram() const { return psram.valid(); }
+
+private:
+    Arena internal;
+    Arena psram;
+};
+
+
+// ------- DELAY LINE --------
+/** mono 16 bit ring buffer, halves the memory of float lines */
+struct DelayLine {
+    int16_t *buffer = nullptr;
+    size_t   len = 0;
+    size_t   pos = 0;
+
+    bool begin(FxArena &arena, size_t frames);
+    void clear();
+    /** zeroes frames [from, from + frames), clipped to the line */
+    void clear_range(size_t from, size_t frames);
+
+    FORCE_INLINE void write(float x) {
+        x = x > 1.f ? 1.f : (x < -1.f ? -1.f : x);
+        buffer[pos] = (int16_t)(x * INT16_MAX);
+        pos = pos + 1 < len ? pos + 1 : 0;
+    }
+
+    /** sample written `delay` frames ago, 1 is the last written */
+    FORCE_INLINE float read(size_t delay) const {
+        const size_t i = pos >= delay ? pos - delay : pos + len - delay;
+        return buffer[i] * (1.f / INT16_MAX);
+    }
+
+    FORCE_INLINE float read_frac(float delay) const {
+        const size_t d = (size_t)delay;
+        const float frac = delay - d;
+        return read(d) * (1.f - frac) + read(d + 1) * frac;
+    }
+};
+
+
+// ------- CONFIGS --------
+struct DelayConfig {
+    float mix = 0.f;
+    float feedback = 0.4f;
+    float beats = 0.5f;     // delay time as a fraction of a beat at the arpeggiator tempo
+};
+
+struct ChorusConfig {
+    float mix = 0.f;
+};
+
+struct ReverbConfig {
+    float mix = 0.f;
+    float size = 0.5f;
+};
+
+struct EffectsConfig {
+    DelayConfig delay;
+    ChorusConfig chorus;
+    ReverbConfig reverb;
+};
+
+
+// ------- EFFECT --------
+class Effect {
+public:
+    const char *name;
+    const uint32_t budget_us;   // expected worst case for a SYNTH_CHUNK_SIZE block
+
+    virtual bool begin(FxArena &arena) = 0;
+    virtual void configure(const EffectsConfig &config, float tempo_bpm) = 0;
+    virtual void process_block(StereoSample *data, size_t len) = 0;
+
+    /** once per block from the chain: processes when enabled, otherwise clears the next slice of old samples */
+    void step(StereoSample *data, size_t len);
+
+    bool enabled() const { return _ready && _enabled; }
+    /** the lines still hold samples from before the effect was disabled, it stays silent until they are gone */
+    bool clearing() const { return _dirty && !_running; }
+    /** while held configure only turns the effect on, a morph through mix 0 would restart the clear */
+    void hold(bool held) { _held = held; }
+    void profile(uint32_t elapsed_us);
+
+    virtual ~Effect() = default;
+
+protected:
+    bool _ready = false;
+    bool _enabled = false;
+
+    Effect(const char *name, uint32_t budget_us)
+        : name(name), budget_us(budget_us) {}
+
+    void enable(bool wanted) { _enabled = wanted || (_held && _enabled); }
+
+    /** zeroes frames [from, from + frames) of every line, true once that reaches the end of the longest */
+    virtual bool clear_slice(size_t from, size_t frames) = 0;
+
+private:
+    bool _held = false;
+    bool _running = false;  // processed the last block
+    bool _dirty = false;    // lines written since the last full clear
+    size_t clear_from = 0;
+
+    uint32_t worst_us = 0;
+    uint32_t profiled_blocks = 0;
+};
+
+
+/** tempo synced ping-pong delay, the feedback crosses channels */
+class StereoDelay : public Effect {
+public:
+    StereoDelay() : Effect("delay", 120) {}
+
+    bool begin(FxArena &arena) override;
+    void configure(const EffectsConfig &config, float tempo_bpm) override;
+    void process_block(StereoSample *data, size_t len) override;
+
+protected:
+    bool clear_slice(size_t from, size_t frames) override;
+
+private:
+    DelayLine line_left;
+    DelayLine line_right;
+    size_t delay_frames = 1;
+    float mix = 0.f;
+    float feedback = 0.f;
+};
+
+
+/** single voice chorus, the right lfo runs a quarter period behind the left */
+class StereoChorus : public Effect {
+public:
+    StereoChorus() : Effect("chorus", 200) {}
+
+    bool begin(FxArena &arena) override;
+    void configure(const EffectsConfig &config, float tempo_bpm) override;
+    void process_block(StereoSample *data, size_t len) override;
+
+protected:
+    bool clear_slice(size_t from, size_t frames) override;
+
+private:
+    DelayLine line_left;
+    DelayLine line_right;
+    float lfo_phase = 0.f;
+    float mix = 0.f;
+};
+
+
+/** schroeder/freeverb style: 4 damped combs and 2 allpasses per channel at half the freeverb lengths */
+class LiteReverb : public Effect {
+public:
+    LiteReverb() : Effect("reverb", 600) {}
+
+    bool begin(FxArena &arena) override;
+    void configure(const EffectsConfig &config, float tempo_bpm) override;
+    void process_block(StereoSample *data, size_t len) override;
+
+    static constexpr size_t COMB_COUNT = 4;
+    static constexpr size_t ALLPASS_COUNT = 2;
+
+protected:
+    bool clear_slice(size_t from, size_t frames) override;
+
+private:
+    struct Comb {
+        DelayLine line;
+        float filter_state = 0.f;
+    };
+
+    struct Channel {
+        Comb combs[COMB_COUNT];
+        DelayLine allpasses[ALLPASS_COUNT];
+    };
+
+    Channel channels[2];
+    float mix = 0.f;
+    float feedback = 0.f;
+    float damping = 0.3f;
+
+    static float process_channel(Channel &ch, float input, float feedback, float damping);
+};
+
+
+// ------- CHAIN --------
+class EffectsChain {
+public:
+    void begin();
+    /** hold keeps enabled effects on whatever the mix, for config morphs */
+    void configure(const EffectsConfig &config, float tempo_bpm, bool hold = false);
+    void process_block(StereoSample *data, size_t len);
+
+private:
+    FxArena arena;
+    StereoChorus chorus;
+    StereoDelay delay;
+    LiteReverb reverb;
+
+    static constexpr size_t MAX_EFFECTS = 3;
+    Effect *effects[MAX_EFFECTS] = { &chorus, &delay, &reverb };
+};
@@ -64,3 +64,31 @@ MidiNote NoteTracker::right_of(MidiNote x) const {
     if(res == MidiNote::None) res = smallest();
     return res;
 }
+
+
+// times wrap every ~71 minutes, compare by signed difference
+static inline bool time_before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+bool MidiScheduler::push(const TimedMidiEvent &event) {
+    if(count >= MIDI_SCHEDULER_SIZE) return false;
+
+    // insertion keeps the array sorted, equal times keep arrival order
+    size_t i = count++;
+    while(i > 0 && time_before(event.time_us, events[i - 1].time_us)) {
+        events[i] = events[i - 1];
+        i--;
+    }
+    events[i] = event;
+    return true;
+}
+
+bool MidiScheduler::pop_due(uint32_t until_us, TimedMidiEvent *out) {
+    if(count == 0 || !time_before(events[0].time_us, until_us)) return false;
+
+    *out = events[0];
+    count--;
+    for(size_t i = 0; i < count; i++) events[i] = events[i + 1];
+    return true;
+}
@@ -8,6 +8,8 @@ namespace MidiEventType {
         Empty = 0,
         NoteOn,
         NoteOff,
+        ControlChange,
+        ProgramChange,
         Other,
     };
 }
@@ -72,6 +74,10 @@ struct __attribute__((packed)) MidiEvent {
             return MidiEventType::NoteOn;
         else if (cin == 0x8 || (cin == 0x9 && data2 == 0)) 
             return MidiEventType::NoteOff;
+        else if (cin == 0xB)
+            return MidiEventType::ControlChange;
+        else if (cin == 0xC)
+            return MidiEventType::ProgramChange;
         else 
             return MidiEventType::Other;
     }
@@ -80,12 +86,55 @@ struct __attribute__((packed)) MidiEvent {
         return MidiNote(data1);
     }
 
+    inline uint8_t get_program() const {
+        return data1;
+    }
+
+    inline uint8_t get_control() const {
+        return data1;
+    }
+
+    inline uint8_t get_control_value() const {
+        return data2;
+    }
+
     inline uint8_t get_velocity() const{
         return data2;
     }
 };
 
 
+/** an event and the esp_timer time it should sound at, sources without timing use the time they received it */
+struct TimedMidiEvent {
+    MidiEvent event;
+    uint32_t  time_us;
+};
+
+
+constexpr size_t MIDI_SCHEDULER_SIZE = 64;   // two full ble-midi packets (BLE_MIDI_MAX_EVENTS)
+
+/** pending events ordered by time, fixed size so the audio task never allocates */
+class MidiScheduler {
+public:
+    /** false when full */
+    bool push(const TimedMidiEvent &event);
+    /** earliest event due before until_us */
+    bool pop_due(uint32_t until_us, TimedMidiEvent *out);
+    bool full() const { return count >= MIDI_SCHEDULER_SIZE; }
+
+    /** takes what the rings hold, when full the rest waits there until due events made room */
+    template<typename RingA, typename RingB>
+    void collect(RingA &a, RingB &b) {
+        TimedMidiEvent event;
+        while(!full() && (a.pop(&event) || b.pop(&event))) push(event);
+    }
+
+private:
+    TimedMidiEvent events[MIDI_SCHEDULER_SIZE];
+    size_t count = 0;
+};
+
+
 constexpr size_t MAX_TRACKED_NOTES = 5;
 
 
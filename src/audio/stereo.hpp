@@ -0,0 +1,7 @@
+#pragma once
+
+/** interleaved in the same order as the i2s frames (I2S_CHANNEL_FMT_RIGHT_LEFT) */
+struct StereoSample {
+    float right;
+    float left;
+};
@@ -1,4 +1,5 @@
 #include "synth.hpp"
+#include <cstring>
 #include "wavetable.hpp"
 #include "audio_math.hpp"
 
@@ -9,7 +10,7 @@ FORCE_INLINE float OscState::step(float dt, const OscillatorConfig &config) {
     
     dt *= config.freq_mult;
     this->phase = std::modf(this->phase + dt, &intpart);
-    return waves[config.wave_index](this->phase) * config.gain_mult;
+    return waves[config.wave_index](this->phase);
 }
 
 FORCE_INLINE void EnvelopeState::step() {
@@ -61,16 +62,28 @@ static FORCE_INLINE float fast_tanh(float x)
     ((current) + ((target) - (current)) * (rate))
 
 #define SYNTH_LOWPASS_CUTOFF_TIMING_SECS 0.1f
+#define SYNTH_PARAM_SMOOTHING_SECS 0.01f
+
+FORCE_INLINE void SmoothedGains::step(const SynthConfig &config, float rate) {
+    const OscillatorConfig *oscs[3] = { &config.osc1, &config.osc2, &config.osc3 };
+
+    for(size_t i = 0; i < 3; i++) {
+        osc_left[i]  = EXP_APPROACH(oscs[i]->gain_mult * oscs[i]->pan_left,  osc_left[i],  rate);
+        osc_right[i] = EXP_APPROACH(oscs[i]->gain_mult * oscs[i]->pan_right, osc_right[i], rate);
+    }
+
+    output = EXP_APPROACH(config.boost.gain_mult, output, rate);
+}
 
 /**
  * adapted from: https://github.com/ddiakopoulos/MoogLadders
  * added dynamic frequency
  */
-void LowPassState::process_block(float *samples, size_t n, const LowPassConfig &config) {
+void LowPassState::process_block(float *samples, size_t n, const LowPassConfig &config, size_t stride) {
     float k = config.emphasis_perc * 4;
     float base_wc = HZ_TO_WC(config.cutoff_hz);
 
-    for (size_t i = 0; i < n; ++i)
+    for (size_t i = 0; i < n * stride; i += stride)
     {
         current_wc = EXP_APPROACH(base_wc, current_wc, 1.f / (SYNTH_LOWPASS_CUTOFF_TIMING_SECS * SYNTH_SR));
  
@@ -102,13 +115,39 @@ void Synth::process_midi_event(const MidiEvent &event)
             tracker.pop(event.get_note());
             break;
         }
+        // control and program changes reach the ui, not the voice
+        default:
+            break;
     }
 }
 
 
 
-void Synth::process_block(float *data, size_t len) {
-    sync_config();
+void Synth::render_chunk(StereoSample *data, MidiScheduler &scheduler, uint32_t block_start_us) {
+    static const uint32_t block_us = SYNTH_CHUNK_SIZE * 1000000ull / SYNTH_SR;
+    TimedMidiEvent midi_event;
+    size_t rendered = 0;
+
+    memset(data, 0, SYNTH_CHUNK_SIZE * sizeof(StereoSample));
+
+    while(scheduler.pop_due(block_start_us + block_us, &midi_event)) {
+        const int32_t due_us = (int32_t)(midi_event.time_us - block_start_us);
+        const size_t offset = due_us <= 0 ? 0 : constrain((size_t)((uint64_t)due_us * SYNTH_SR / 1000000), (size_t)0, SYNTH_CHUNK_SIZE);
+
+        if(offset > rendered) {
+            process_block(data + rendered, offset - rendered);
+            rendered = offset;
+        }
+        process_midi_event(midi_event.event);
+    }
+
+    if(rendered < SYNTH_CHUNK_SIZE)
+        process_block(data + rendered, SYNTH_CHUNK_SIZE - rendered);
+}
+
+
+void Synth::process_block(StereoSample *data, size_t len) {
+    sync_config(len);
 
     const auto last_note = tracker.most_recent();
     // not playing any notes
@@ -145,6 +184,7 @@ void Synth::process_block(float *data, size_t len) {
     voice_state.envelope_state.set_rates(config.envelope);
     const float freq = voice_state.note.get_frequency();
     const float dt = 1.f / SYNTH_SR * freq;
+    const float smoothing_rate = 1.f / (SYNTH_PARAM_SMOOTHING_SECS * SYNTH_SR);
     
     // compute block
     for(size_t i = 0; i < len; i++) {
@@ -155,27 +195,115 @@ void Synth::process_block(float *data, size_t len) {
 
         // envelope
         voice_state.envelope_state.step();
-        data[i] = (y1 + y2 + y3) * voice_state.envelope_state.value;
+        const float env = voice_state.envelope_state.value;
+
+        // gain and pan
+        gains.step(config, smoothing_rate);
+        const float left  = (y1 * gains.osc_left[0]  + y2 * gains.osc_left[1]  + y3 * gains.osc_left[2])  * env;
+        const float right = (y1 * gains.osc_right[0] + y2 * gains.osc_right[1] + y3 * gains.osc_right[2]) * env;
 
         // boost
-        data[i] = saturate_hard(data[i] * config.boost.boost_mult) * config.boost.gain_mult; 
+        data[i].left  = saturate_hard(left  * config.boost.boost_mult) * gains.output;
+        data[i].right = saturate_hard(right * config.boost.boost_mult) * gains.output;
     }
 
     // apply low pass
-    // lowpass_state.process_block(data, len, config.lowpass);
+    // lowpass_left.process_block(&data[0].left,   len, config.lowpass, 2);
+    // lowpass_right.process_block(&data[0].right, len, config.lowpass, 2);
+
+    // post synth effects
+    effects.process_block(data, len);
 
     // saturate for good measure
     for(size_t i = 0; i < len; i++) {
-        data[i] = saturate_hard(data[i]);
+        data[i].left  = saturate_hard(data[i].left);
+        data[i].right = saturate_hard(data[i].right);
     }
+
+    sounding.store(voice_state.enabled || voice_state.envelope_state.section != EnvelopeSection::Off, std::memory_order_relaxed);
 }
 
 
-void Synth::update_config(const SynthConfig &new_config) {
-    xQueueOverwrite(config_queue, &new_config);
+void Synth::update_config(const SynthConfig &new_config, float morph_secs) {
+    ConfigUpdate update = { new_config, morph_secs };
+
+    // a plain update only moves the target of a morph the audio task has not started yet.
+    // if it starts in between, the morph restarts from where it got to, it never gets lost
+    ConfigUpdate pending;
+    if(morph_secs <= 0.f && xQueuePeek(config_queue, &pending, 0) == pdTRUE)
+        update.morph_secs = pending.morph_secs;
+
+    xQueueOverwrite(config_queue, &update);
+}
+
+
+void Synth::sync_config(size_t len) {
+    static ConfigUpdate update;
+
+    if(xQueueReceive(config_queue, &update, 0) == pdTRUE) {
+        if(update.morph_secs > 0.f)  morph.start(config, update.config, update.morph_secs);
+        else if(morph.active())     morph.retarget(update.config);
+
+        // discrete fields take the new values now, the morph owns the continuous ones
+        config = update.config;
+        if(!morph.active()) {
+            effects.configure(config.effects, config.arpeggiator.tempo_bpm);
+            return;
+        }
+    }
+
+    if(morph.active()) {
+        morph.apply(config, len);
+        // effects switch on when their mix leaves 0 and off only at the end
+        effects.configure(config.effects, config.arpeggiator.tempo_bpm, morph.active());
+    }
+}
+
+
+// ------- MORPH --------
+#define MORPH_OFFSET(field) offsetof(SynthConfig, field)
+
+static const size_t SYNTH_MORPH_OFFSETS[] = {
+    MORPH_OFFSET(osc1.freq_mult), MORPH_OFFSET(osc1.gain_mult), MORPH_OFFSET(osc1.pan_left), MORPH_OFFSET(osc1.pan_right),
+    MORPH_OFFSET(osc2.freq_mult), MORPH_OFFSET(osc2.gain_mult), MORPH_OFFSET(osc2.pan_left), MORPH_OFFSET(osc2.pan_right),
+    MORPH_OFFSET(osc3.freq_mult), MORPH_OFFSET(osc3.gain_mult), MORPH_OFFSET(osc3.pan_left), MORPH_OFFSET(osc3.pan_right),
+    MORPH_OFFSET(envelope.attack_secs), MORPH_OFFSET(envelope.decay_secs),
+    MORPH_OFFSET(envelope.sustain_gain), MORPH_OFFSET(envelope.release_secs),
+    MORPH_OFFSET(boost.boost_mult), MORPH_OFFSET(boost.gain_mult),
+    MORPH_OFFSET(lowpass.cutoff_hz), MORPH_OFFSET(lowpass.emphasis_perc), MORPH_OFFSET(lowpass.countour_dhz),
+    MORPH_OFFSET(lowpass.cutoff_envelope.attack_secs), MORPH_OFFSET(lowpass.cutoff_envelope.decay_secs),
+    MORPH_OFFSET(lowpass.cutoff_envelope.sustain_gain), MORPH_OFFSET(lowpass.cutoff_envelope.release_secs),
+    MORPH_OFFSET(effects.delay.mix), MORPH_OFFSET(effects.delay.feedback),
+    MORPH_OFFSET(effects.chorus.mix),
+    MORPH_OFFSET(effects.reverb.mix), MORPH_OFFSET(effects.reverb.size),
+};
+
+static_assert(sizeof(SYNTH_MORPH_OFFSETS) / sizeof(size_t) == SYNTH_MORPH_FIELDS, "SYNTH_MORPH_FIELDS out of date");
+
+FORCE_INLINE static float morph_read(const SynthConfig &config, size_t i) {
+    return *(const float*)((const uint8_t*)&config + SYNTH_MORPH_OFFSETS[i]);
+}
+
+FORCE_INLINE static float &morph_field(SynthConfig &config, size_t i) {
+    return *(float*)((uint8_t*)&config + SYNTH_MORPH_OFFSETS[i]);
+}
+
+void ConfigMorph::start(const SynthConfig &current, const SynthConfig &target, float secs) {
+    for(size_t i = 0; i < SYNTH_MORPH_FIELDS; i++) from[i] = morph_read(current, i);
+    retarget(target);
+
+    pos = 0.f;
+    step = 1.f / (secs * SYNTH_SR);
+}
+
+void ConfigMorph::retarget(const SynthConfig &target) {
+    for(size_t i = 0; i < SYNTH_MORPH_FIELDS; i++) to[i] = morph_read(target, i);
 }
 
+void ConfigMorph::apply(SynthConfig &config, size_t len) {
+    pos += step * len;
+    if(pos > 1.f) pos = 1.f;
 
-void Synth::sync_config() {
-    xQueueReceive(config_queue, &config, 0);
+    for(size_t i = 0; i < SYNTH_MORPH_FIELDS; i++)
+        morph_field(config, i) = from[i] + (to[i] - from[i]) * pos;
 }
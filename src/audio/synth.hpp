@@ -1,10 +1,13 @@
 #pragma once
 #include <cstddef>
 #include <cstdint>
+#include <atomic>
 #include "midi.hpp"
 #include "config.h"
 #include "perf.h"
 #include "arpeggiator.hpp"
+#include "stereo.hpp"
+#include "effects.hpp"
 
 // ------- OSCILLATOR --------
 struct OscillatorConfig {
@@ -12,10 +15,18 @@ struct OscillatorConfig {
     uint8_t wave_index = 0;
     float freq_mult = 1;
     float gain_mult = 1;
+    float pan_left  = 1;
+    float pan_right = 1;
 
-    inline void set_freq_mult(float base_mult, int32_t detune_cents) {
+    inline void set_freq_mult(float base_mult, float detune_cents) {
         freq_mult = base_mult * powf(2.0f, detune_cents / 1200.0f);
     }
+
+    /** balance law: unity gain at center, the opposite channel fades to zero at the sides (-1 left, +1 right) */
+    inline void set_pan(float pan) {
+        pan_left  = pan > 0.f ? 1.f - pan : 1.f;
+        pan_right = pan < 0.f ? 1.f + pan : 1.f;
+    }
 };
 
 struct OscState {
@@ -88,7 +99,7 @@ struct LowPassState {
 
     float current_wc = 0.f;
 
-    void process_block(float *samples, size_t n, const LowPassConfig &config);
+    void process_block(float *samples, size_t n, const LowPassConfig &config, size_t stride = 1);
 };
 
 
@@ -96,7 +107,7 @@ struct LowPassState {
 
 class TPTLowPass {
 public:
-    void process_block(float* samples, size_t n, const LowPassConfig& config) {
+    void process_block(float* samples, size_t n, const LowPassConfig& config, size_t stride = 1) {
         // Convert cutoff Hz to angular frequency (rad/s)
         float wc = 2.0f * (float)M_PI * config.cutoff_hz;
         float T = 1.0f / SYNTH_SR;
@@ -107,7 +118,7 @@ public:
         if (R > 1.0f) R = 1.0f;
         if (R < 0.0f) R = 0.0f;
 
-        for (size_t i = 0; i < n; ++i) {
+        for (size_t i = 0; i < n * stride; i += stride) {
             float v = (samples[i] - R * state_ - state_) / (1.0f + g);
             float lp = v + state_;
             state_ = lp + v;
@@ -144,17 +155,67 @@ struct SynthConfig {
     EnvelopeConfig envelope;
     BoostConfig boost;
     LowPassConfig lowpass;
+    EffectsConfig effects;
+};
+
+
+// ------- MORPH --------
+// continuous (float) fields of SynthConfig, see SYNTH_MORPH_OFFSETS
+#define SYNTH_MORPH_FIELDS 30
+
+struct ConfigUpdate {
+    SynthConfig config;
+    float morph_secs;   // 0 applies at once
+};
+
+/**
+ * glides the continuous parameters between two configs at control rate (once per block),
+ * the per sample smoothing below covers the steps. discrete fields switch at the start,
+ * so do tempo and delay beats: a gliding delay time would step the read position every block
+ */
+struct ConfigMorph {
+    float from[SYNTH_MORPH_FIELDS];
+    float to[SYNTH_MORPH_FIELDS];
+    float pos = 1.f;
+    float step = 0.f;   // pos per sample
+
+    bool active() const { return pos < 1.f; }
+    void start(const SynthConfig &current, const SynthConfig &target, float secs);
+    /** new target mid morph, the remaining time stays the same */
+    void retarget(const SynthConfig &target);
+    /** advances by len samples and writes the interpolated fields into config */
+    void apply(SynthConfig &config, size_t len);
+};
+
+
+// ------- SMOOTHING --------
+/** per sample smoothed copies of the gain parameters, config changes never step the output */
+struct SmoothedGains {
+    float osc_left[3]  = { 0.f, 0.f, 0.f };
+    float osc_right[3] = { 0.f, 0.f, 0.f };
+    float output = 0.f;
+
+    FORCE_INLINE void step(const SynthConfig &config, float rate);
 };
 
 
 class Synth {
 public:
-    void update_config(const SynthConfig &new_config);
+    /** morph_secs > 0 glides from the playing config instead of switching */
+    void update_config(const SynthConfig &new_config, float morph_secs = 0.f);
     void process_midi_event(const MidiEvent &event);
-    void process_block(float *data, size_t len);
+    void process_block(StereoSample *data, size_t len);
+    /**
+     * one SYNTH_CHUNK_SIZE block starting at block_start_us, split where the events due in it fall
+     * so each one starts on its sample
+     */
+    void render_chunk(StereoSample *data, MidiScheduler &scheduler, uint32_t block_start_us);
+    /** a voice is held or still releasing, as of the last block. safe to read from any task */
+    bool is_sounding() const { return sounding.load(std::memory_order_relaxed); }
 
     void begin() {
-        config_queue = xQueueCreate(1, sizeof(SynthConfig));
+        config_queue = xQueueCreate(1, sizeof(ConfigUpdate));
+        effects.begin();
     }
 
 private:
@@ -162,10 +223,15 @@ private:
 
     ArpeggiatorState arp_state;
     VoiceState voice_state;
-    TPTLowPass lowpass_state;
+    TPTLowPass lowpass_left;
+    TPTLowPass lowpass_right;
+    EffectsChain effects;
+    SmoothedGains gains;
 
     QueueHandle_t config_queue;
     SynthConfig config;
+    ConfigMorph morph;
+    std::atomic<bool> sounding { false };
 
-    void sync_config();
+    void sync_config(size_t len);
 };
@@ -0,0 +1,125 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "audio/midi.hpp"
+
+/**
+ * BLE-MIDI packet: header (10hhhhhh), then messages each preceded by a timestamp byte (1lllllll).
+ * a message without its own timestamp continues the previous one with running status.
+ * the 13 bit millisecond timestamp is the sender clock, low byte wraps increment the high bits.
+ */
+struct BleMidiDecoder {
+    /** calls emit(event, timestamp_ms) for every channel message, false when the packet is malformed */
+    template<typename F>
+    bool decode(const uint8_t *data, size_t len, F emit) {
+        if(len < 2 || (data[0] & 0xC0) != 0x80) return false;
+
+        uint16_t ts_high = data[0] & 0x3F;
+        uint8_t ts_low = 0;
+        uint16_t timestamp = 0;
+        size_t i = 1;
+
+        while(i < len) {
+            // timestamp, optionally followed by a status byte
+            if(data[i] & 0x80) {
+                const uint8_t low = data[i] & 0x7F;
+                if(low < ts_low) ts_high = (ts_high + 1) & 0x3F;
+                ts_low = low;
+                timestamp = ts_high << 7 | low;
+                if(++i >= len) return false;
+
+                const uint8_t status = data[i];
+                if(status & 0x80) {
+                    i++;
+                    if(in_sysex) {
+                        if(status == 0xF7) in_sysex = false;
+                        continue;
+                    }
+                    if(status == 0xF0)  { in_sysex = true; continue; }
+                    if(status >= 0xF8)  continue;                    // realtime, running status survives
+                    if(status >= 0xF0)  {                            // system common, not handled
+                        running_status = 0;
+                        while(i < len && !(data[i] & 0x80)) i++;
+                        continue;
+                    }
+                    running_status = status;
+                }
+            }
+
+            // data bytes: sysex body, or a message with the running status
+            if(in_sysex || running_status == 0) {
+                i++;
+                continue;
+            }
+
+            const size_t data_len = message_data_len(running_status);
+            if(i + data_len > len) return false;
+
+            MidiEvent event;
+            event.header = running_status >> 4;     // usb midi code index number, cable 0
+            event.status = running_status;
+            event.data1 = data[i];
+            event.data2 = data_len > 1 ? data[i + 1] : 0;
+            emit(event, timestamp);
+            i += data_len;
+        }
+
+        return true;
+    }
+
+private:
+    uint8_t running_status = 0;
+    bool in_sysex = false;
+
+    static size_t message_data_len(uint8_t status) {
+        const uint8_t kind = status & 0xF0;
+        return (kind == 0xC0 || kind == 0xD0) ? 1 : 2;
+    }
+};
+
+
+/**
+ * maps sender timestamps to local time. the least delayed packet seen gives the clock offset,
+ * every event then plays jitter_ms after the time it would have arrived on that best case,
+ * so the spacing between notes survives the connection interval batching.
+ */
+struct BleMidiClock {
+    static constexpr uint16_t TS_MASK = 0x1FFF;
+    static constexpr int16_t  RESYNC_MS = 1000;     // later than this: the sender clock restarted
+    static constexpr uint32_t DRIFT_US = 1000000;   // the offset creeps 1ms per second, follows clock drift
+
+    /** call once per packet with its latest timestamp, before placing its events */
+    void observe(uint16_t timestamp, uint32_t arrival_us) {
+        const uint16_t delta = (ms(arrival_us) - timestamp) & TS_MASK;
+        const int16_t lateness = wrap(delta - min_delta);
+
+        if(!synced || lateness < 0 || lateness > RESYNC_MS) {
+            synced = true;
+            min_delta = delta;
+            last_update_us = arrival_us;
+        }
+        else if(arrival_us - last_update_us > DRIFT_US) {
+            min_delta = (min_delta + 1) & TS_MASK;
+            last_update_us = arrival_us;
+        }
+    }
+
+    /** esp_timer time the event should sound at, never before arrival */
+    uint32_t to_local_us(uint16_t timestamp, uint32_t arrival_us, uint16_t jitter_ms) const {
+        const int16_t lateness = wrap(((ms(arrival_us) - timestamp) & TS_MASK) - min_delta);
+        if(lateness >= jitter_ms) return arrival_us;
+        return arrival_us + (jitter_ms - lateness) * 1000;
+    }
+
+private:
+    bool synced = false;
+    uint16_t min_delta = 0;
+    uint32_t last_update_us = 0;
+
+    static uint16_t ms(uint32_t us) { return (us / 1000) & TS_MASK; }
+
+    /** modular difference into [-4096, 4095] */
+    static int16_t wrap(int32_t diff) {
+        return (int16_t)(((diff + 4096) & TS_MASK) - 4096);
+    }
+};
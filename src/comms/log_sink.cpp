@@ -0,0 +1,106 @@
+#include "log_sink.hpp"
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/ringbuf.h"
+#include "config.h"
+
+static RingbufHandle_t s_ring = nullptr;
+
+// one writer each: s_written the drain task, the other two the pushing task. read by the others for reports
+static volatile uint32_t s_written = 0;
+static volatile uint32_t s_dropped = 0;
+static volatile uint32_t s_rate_limited = 0;
+
+// token bucket, one token per line
+static uint32_t s_tokens = LOG_SINK_RATE_BURST;
+static uint32_t s_refill_ms = 0;
+
+static const PacketDecoder::Errors *volatile s_decoder_errors = nullptr;
+
+
+void log_sink::begin() {
+    // nosplit keeps every line contiguous, the reader gets it in one piece
+    s_ring = xRingbufferCreate(LOG_SINK_BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+}
+
+bool log_sink::push(const uint8_t *data, size_t len) {
+    if(!s_ring) return false;
+
+    const uint32_t now = millis();
+    const uint32_t refill = (uint64_t)(now - s_refill_ms) * LOG_SINK_RATE_PER_SEC / 1000;
+    if(s_tokens + refill >= LOG_SINK_RATE_BURST) {
+        // full, there is no remainder worth keeping
+        s_tokens = LOG_SINK_RATE_BURST;
+        s_refill_ms = now;
+    }
+    else if(refill > 0) {
+        s_tokens += refill;
+        // only the time turned into tokens, the remainder counts towards the next one
+        s_refill_ms += refill * 1000 / LOG_SINK_RATE_PER_SEC;
+    }
+
+    if(s_tokens == 0) {
+        s_rate_limited = s_rate_limited + 1;
+        return false;
+    }
+    s_tokens--;
+
+    if(xRingbufferSend(s_ring, data, len, 0) != pdTRUE) {
+        s_dropped = s_dropped + 1;
+        return false;
+    }
+    return true;
+}
+
+log_sink::Stats log_sink::stats() {
+    return { s_written, s_dropped, s_rate_limited };
+}
+
+void log_sink::watch_decoder(const PacketDecoder::Errors *errors) {
+    s_decoder_errors = errors;
+}
+
+/** prints the packets dropped since the last report, if any */
+static void report_decoder(PacketDecoder::Errors &reported) {
+    const PacketDecoder::Errors *errors = s_decoder_errors;
+    if(!errors) return;
+
+    const uint32_t overflow = errors->overflow;
+    const uint32_t bad_escape = errors->bad_escape;
+    const uint32_t crc = errors->crc;
+    if(overflow == reported.overflow && bad_escape == reported.bad_escape && crc == reported.crc) return;
+
+    Serial.printf("UART RX: packets dropped, too long=%d broken escape=%d crc=%d\n",
+        overflow - reported.overflow, bad_escape - reported.bad_escape, crc - reported.crc);
+    reported.overflow = overflow;
+    reported.bad_escape = bad_escape;
+    reported.crc = crc;
+}
+
+void log_sink::drain_task(void *arg) {
+    uint32_t reported_lost = 0;
+    PacketDecoder::Errors reported_decoder;
+
+    while(true) {
+        // the timeout reports losses even when no line follows them
+        size_t len = 0;
+        uint8_t *line = (uint8_t*) xRingbufferReceive(s_ring, &len, pdMS_TO_TICKS(LOG_SINK_LOST_REPORT_MS));
+
+        if(line) {
+            // lines are written by length, the payload is not nul terminated
+            Serial.print("UART LOG: ");
+            Serial.write(line, len);
+            Serial.println();
+            vRingbufferReturnItem(s_ring, line);
+            s_written = s_written + 1;
+        }
+
+        // a gap in the output is reported once, right where it happened
+        const uint32_t lost = s_dropped + s_rate_limited;
+        if(lost != reported_lost) {
+            Serial.printf("UART LOG: %d lines lost\n", lost - reported_lost);
+            reported_lost = lost;
+        }
+        report_decoder(reported_decoder);
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "uart_rx.hpp"
+
+/**
+ * console output for the log packets of the uart peer. push only copies into a ring buffer,
+ * a low priority task does the slow serial writes, so midi decoding never waits on the console
+ */
+namespace log_sink {
+    struct Stats {
+        uint32_t written;
+        uint32_t dropped;       // ring buffer full
+        uint32_t rate_limited;  // over LOG_SINK_RATE_PER_SEC
+    };
+
+    void begin();
+    /** never blocks, false when the line was dropped */
+    bool push(const uint8_t *data, size_t len);
+    Stats stats();
+    /** the drain task also reports the packets this decoder dropped */
+    void watch_decoder(const PacketDecoder::Errors *errors);
+
+    void drain_task(void *arg);
+};
@@ -1,8 +1,8 @@
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
-#include <esp_log.h>
-
-static const char *DECODER_TAG = "PACKET_DECODER";
+#include <assert.h>
+#include "generated/crc16.hpp"
 
 struct Packet {
     uint8_t type = 0x00;
@@ -10,41 +10,49 @@ struct Packet {
     size_t payload_len = 0;
 };
 
+/** crc16/x-25, one table lookup per byte */
 static inline __attribute__((always_inline)) 
 void crc16_add(uint16_t *crc, uint8_t x) {
-    *crc ^= x;
-    for (int j = 0; j < 8; j++) {
-        if (*crc & 1)
-            *crc = (*crc >> 1) ^ 0x8408;
-        else
-            *crc >>= 1;
-    }
+    *crc = (*crc >> 8) ^ crc16_table[(*crc ^ x) & 0xFF];
 }
 
 struct PacketDecoder {
+    /** dropped packets by cause. counted only, the rx task never waits on the console for them */
+    struct Errors {
+        volatile uint32_t overflow = 0;
+        volatile uint32_t bad_escape = 0;
+        volatile uint32_t crc = 0;
+    };
+
     inline __attribute__((always_inline)) bool decode(uint8_t x, Packet *out) {
         bool decoded_packet = false;
 
         switch(x) {
             case 0x7E: {
                 size_t packet_len = write_index;
-                if(packet_len >= 4 && packet_len <= MAX_PACKET_LEN) {
-                    if(verify_self(packet_len)) {
+                // a 0x7D right before the delimiter escapes nothing, the byte it stood for is lost
+                if(escaping) bad_escape = true;
+
+                if(overflow) {
+                    _errors.overflow = _errors.overflow + 1;
+                }
+                else if(bad_escape) {
+                    _errors.bad_escape = _errors.bad_escape + 1;
+                }
+                else if(packet_len >= 4) {
+                    // the crc runs over the received crc too, a valid packet leaves the residue
+                    if(crc == CRC16_RESIDUE) {
                         out->type = buffer[1];
                         out->payload = buffer + 2;
                         out->payload_len = write_index - 2 - 2; // -header size -crc size
                         assert(out->payload_len <= MAX_PAYLOAD_LEN);
                         decoded_packet = true;
                     } else {
-                        ESP_LOGE(DECODER_TAG, "Packet failed CRC check (total: %d)", ++_missed_packets);
+                        _errors.crc = _errors.crc + 1;
                     }
                 }
-                else if (packet_len > MAX_PAYLOAD_LEN) {
-                    ESP_LOGE(DECODER_TAG, "Packet too long %d", packet_len);
-                }
-                
-                write_index = 0;
-                escaping = false;
+
+                reset();
                 break;
             } 
             case 0x7D: {
@@ -52,16 +60,25 @@ struct PacketDecoder {
                 break;
             }
             default: {
-                if(write_index >= MAX_PACKET_LEN) return false; // do not write if out of buffer
-
                 if(escaping) {
-                    if(x == 0x54)         buffer[write_index++] = 0x7D;
-                    else if (x == 0x53)   buffer[write_index++] = 0x7E;
-                    else ESP_LOGE(DECODER_TAG, "Wrong byte after escape: %02X", x);
                     escaping = false;
-                } else {
-                    buffer[write_index++] = x;
+                    if(x == 0x54)         x = 0x7D;
+                    else if (x == 0x53)   x = 0x7E;
+                    else {
+                        // a dropped byte could still pass the crc by chance, the whole packet goes
+                        bad_escape = true;
+                        break;
+                    }
                 }
+
+                // the rest of an overlong packet is skipped up to the next delimiter
+                if(write_index >= MAX_PACKET_LEN) {
+                    overflow = true;
+                    break;
+                }
+
+                buffer[write_index++] = x;
+                crc16_add(&crc, x);
                 break;
             } 
         }
@@ -69,10 +86,14 @@ struct PacketDecoder {
         return decoded_packet;
     }
 
+    const Errors &errors() const { return _errors; }
+
     void reset() {
-        //memset
         write_index = 0;
         escaping = false;
+        overflow = false;
+        bad_escape = false;
+        crc = 0xFFFF;
     }
     
     static constexpr uint8_t MAX_PAYLOAD_LEN = 128;
@@ -81,17 +102,28 @@ private:
     uint8_t buffer[MAX_PACKET_LEN] = {0};
     size_t write_index = 0;
     bool escaping = false;
-    uint32_t _missed_packets = 0;
+    bool overflow = false;
+    bool bad_escape = false;
+    uint16_t crc = 0xFFFF;      // updated as bytes arrive
+    Errors _errors;
+};
 
-    bool verify_self(size_t packet_len) {
-        uint16_t crc_true = (uint16_t)buffer[packet_len-2] | ((uint16_t)buffer[packet_len-1] << 8);
-        uint16_t crc = 0xFFFF;
 
-        for(size_t i = 0; i < packet_len - 2; i++) {
-            crc16_add(&crc, buffer[i]);
-        }
+/**
+ * decodes pending bytes one chunk at a time. read(buffer, max) returns the bytes it copied, or <= 0 when
+ * nothing is left: the uart driver on the device, a recorded stream in the host tests
+ */
+template<typename Read, typename Handler>
+void decode_chunks(PacketDecoder &decoder, uint8_t *chunk, size_t chunk_size, size_t pending, Read read, Handler handle) {
+    Packet packet;
+
+    while(pending > 0) {
+        const int rx_bytes = read(chunk, pending < chunk_size ? pending : chunk_size);
+        if(rx_bytes <= 0) break;
+        pending -= (size_t)rx_bytes < pending ? (size_t)rx_bytes : pending;
 
-        crc = ~crc;
-        return crc == crc_true;
+        for(int i = 0; i < rx_bytes; i++) {
+            if(decoder.decode(chunk[i], &packet)) handle(packet);
+        }
     }
-};
\ No newline at end of file
+}
@@ -0,0 +1,162 @@
+#include "monitor.hpp"
+#include <Arduino.h>
+#include <cstring>
+#include "config.h"
+#include "remote/remote.hpp"
+#include "comms/log_sink.hpp"
+
+#define MONITOR_MAX_TASKS 32 // all the tasks in the system, idle and ble included
+
+#if configGENERATE_RUN_TIME_STATS == 1 && configUSE_TRACE_FACILITY == 1
+#define MONITOR_HAS_RUN_TIME 1
+#else
+#include "esp_freertos_hooks.h"
+#endif
+
+struct Watched {
+    TaskHandle_t handle;
+    uint32_t stack_size;
+    uint8_t  core;
+    uint32_t last_run_time;
+};
+
+static Watched s_watched[monitor::MAX_WATCHED];
+static size_t  s_watched_count = 0;
+
+
+void monitor::watch(TaskHandle_t task, uint32_t stack_size, uint8_t core) {
+    if(task == nullptr || s_watched_count >= MAX_WATCHED) return;
+    s_watched[s_watched_count++] = { task, stack_size, core, 0 };
+}
+
+
+#ifdef MONITOR_HAS_RUN_TIME
+static TaskStatus_t s_status[MONITOR_MAX_TASKS];
+
+/** fills the cpu usage of the watched tasks and the load of each core over the last period */
+static void sample_run_time(monitor::Report &report) {
+    static uint32_t last_total = 0;
+    static uint32_t last_idle[portNUM_PROCESSORS] = { 0 };
+
+    uint32_t total = 0;
+    const UBaseType_t count = uxTaskGetSystemState(s_status, MONITOR_MAX_TASKS, &total);
+    const uint32_t elapsed = total - last_total;
+    last_total = total;
+    if(count == 0 || elapsed == 0) return;
+
+    for(size_t core = 0; core < portNUM_PROCESSORS; core++) {
+        const TaskHandle_t idle = xTaskGetIdleTaskHandleForCPU(core);
+
+        for(size_t i = 0; i < count; i++) {
+            if(s_status[i].xHandle != idle) continue;
+
+            const uint32_t idle_time = s_status[i].ulRunTimeCounter - last_idle[core];
+            last_idle[core] = s_status[i].ulRunTimeCounter;
+            report.core_load_perc[core] = 100 - constrain(idle_time * 100 / elapsed, 0u, 100u);
+        }
+    }
+
+    for(size_t w = 0; w < s_watched_count; w++) {
+        for(size_t i = 0; i < count; i++) {
+            if(s_status[i].xHandle != s_watched[w].handle) continue;
+
+            const uint32_t run_time = s_status[i].ulRunTimeCounter - s_watched[w].last_run_time;
+            s_watched[w].last_run_time = s_status[i].ulRunTimeCounter;
+            report.tasks[w].cpu_perc = constrain(run_time * 100 / elapsed, 0u, 100u);
+        }
+    }
+}
+#else
+// the arduino core ships freertos without run time stats. the idle hooks count their passes instead,
+// a core's load is how far the last period fell short of the idlest one seen so far
+static volatile uint32_t s_idle_passes[portNUM_PROCESSORS] = { 0 };
+
+template<int CORE>
+static bool count_idle() {
+    s_idle_passes[CORE] = s_idle_passes[CORE] + 1;
+    return false;   // called again right away, not once per tick
+}
+
+static void register_idle_hooks() {
+    esp_register_freertos_idle_hook_for_cpu(count_idle<0>, 0);
+#if portNUM_PROCESSORS > 1
+    esp_register_freertos_idle_hook_for_cpu(count_idle<1>, 1);
+#endif
+}
+
+/** fills the load of each core over the last period, the tasks keep cpu_perc 0xFF */
+static void sample_idle(monitor::Report &report) {
+    static uint32_t last_passes[portNUM_PROCESSORS] = { 0 };
+    static uint32_t most_passes[portNUM_PROCESSORS] = { 0 };
+
+    for(size_t core = 0; core < portNUM_PROCESSORS; core++) {
+        const uint32_t total = s_idle_passes[core];
+        const uint32_t passes = total - last_passes[core];
+        last_passes[core] = total;
+
+        if(passes > most_passes[core]) most_passes[core] = passes;
+        if(most_passes[core] == 0) continue;
+        report.core_load_perc[core] = 100 - (uint64_t)passes * 100 / most_passes[core];
+    }
+}
+#endif
+
+
+static void print_report(const monitor::Report &report) {
+    Serial.print("MONITOR: load");
+    for(size_t core = 0; core < portNUM_PROCESSORS; core++)
+        Serial.printf(" core%d=%d%%", core, report.core_load_perc[core]);
+    const auto stream = remote::stream_stats();
+    Serial.printf(" | screen: mtu=%d every=%dms sent=%dB dropped=%d", stream.mtu, stream.interval_ms, stream.bytes_sent, stream.dropped_frames);
+    const auto log = log_sink::stats();
+    Serial.printf(" | peer log: lines=%d dropped=%d limited=%d", log.written, log.dropped, log.rate_limited);
+    Serial.println();
+
+    for(size_t i = 0; i < report.task_count; i++) {
+        const auto &task = report.tasks[i];
+        Serial.printf("MONITOR:   %-8.8s core%d cpu=%3d%% stack free=%5d/%d\n",
+            task.name, task.core, task.cpu_perc, task.stack_free, task.stack_size);
+    }
+}
+
+
+static void monitor_task(void *arg) {
+    static monitor::Report report;
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while(true) {
+        memset(&report, 0xFF, offsetof(monitor::Report, task_count));
+        report.task_count = s_watched_count;
+
+        for(size_t i = 0; i < s_watched_count; i++) {
+            auto &task = report.tasks[i];
+            strncpy(task.name, pcTaskGetName(s_watched[i].handle), sizeof(task.name) - 1);
+            task.name[sizeof(task.name) - 1] = '\0';
+            task.core = s_watched[i].core;
+            task.cpu_perc = 0xFF;
+            task.stack_size = s_watched[i].stack_size;
+            task.stack_free = uxTaskGetStackHighWaterMark(s_watched[i].handle);
+        }
+
+#ifdef MONITOR_HAS_RUN_TIME
+        sample_run_time(report);
+#else
+        sample_idle(report);
+#endif
+
+        print_report(report);
+        remote::send_stats((const uint8_t*)&report, report.size());
+
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(MONITOR_PERIOD_MS));
+    }
+}
+
+
+void monitor::begin() {
+#ifndef MONITOR_HAS_RUN_TIME
+    register_idle_hooks();
+#endif
+    TaskHandle_t handle = nullptr;
+    xTaskCreatePinnedToCore(monitor_task, "monitor_task", TASK_STACK_MONITOR, NULL, 1, &handle, 1);
+    watch(handle, TASK_STACK_MONITOR, 1);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/**
+ * low priority task that samples the freertos run time stats (or the idle hooks without them) and the
+ * stack high water marks of the watched tasks, then publishes them to serial and to the ble stats characteristic
+ */
+namespace monitor {
+    static constexpr size_t MAX_WATCHED = 8;
+
+    struct __attribute__((packed)) TaskRecord {
+        char     name[8];
+        uint8_t  core;
+        uint8_t  cpu_perc;      // of one core, 0xFF when run time stats are not available
+        uint16_t stack_size;
+        uint16_t stack_free;    // high water mark, bytes never used since boot
+    };
+
+    struct __attribute__((packed)) Report {
+        uint8_t core_load_perc[portNUM_PROCESSORS];     // from the idle hooks when run time stats are not available
+        uint8_t task_count;
+        TaskRecord tasks[MAX_WATCHED];
+
+        size_t size() const { return offsetof(Report, tasks) + task_count * sizeof(TaskRecord); }
+    };
+
+    void watch(TaskHandle_t task, uint32_t stack_size, uint8_t core);
+    void begin();
+};
@@ -1,49 +1,52 @@
 #include "Btn.hpp"
+#include "hal/gpio_ll.h"
 
-void Btn::begin()
+void Btn::begin(QueueHandle_t queue, const Btn *shift)
 {
+    this->queue = queue;
+    this->shift = shift ? shift : this;
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = &Btn::on_settled,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "btn_debounce",
+    };
+    esp_timer_create(&timer_args, &debounce_timer);
+
     pinMode(gpio_pin, INPUT_PULLUP);
+    attachInterruptArg(gpio_pin, &Btn::on_edge, this, CHANGE);
 }
 
-void Btn::update()
+void IRAM_ATTR Btn::on_edge(void *arg)
 {
-    const bool reading = !(bool)digitalRead(gpio_pin);
-    const auto now = millis();
-    this->_event = BtnEvent::None;
+    Btn *self = static_cast<Btn*>(arg);
 
-    if (reading == true)
+    if (!self->settling)
     {
-        if (this->last_reading == false)
-        {
-            // on press (no debounce)
-            this->last_down_millis = now;
-        }
-        else
-        {
-            // kept pressed
-            if ((now - this->last_down_millis) > BTN_DEBOUNCE_MILLIS && !this->_pressed)
-            {
-                // on press
-                this->_pressed = true;
-                this->_event = BtnEvent::Press;
-            }
-        }
-    }
-    else
-    {
-        const bool was_pressed = this->_pressed;
-        this->_pressed = false;
-
-        if (was_pressed == true)
-        {
-            // on release
-            this->_event = BtnEvent::Release;
-        }
-        else
-        {
-            // kept released
-        }
+        self->settling = true;
+        self->first_edge_us = (uint32_t)esp_timer_get_time();
     }
 
-    this->last_reading = reading;
+    // restart the settle window on every bounce
+    esp_timer_stop(self->debounce_timer);
+    esp_timer_start_once(self->debounce_timer, BTN_DEBOUNCE_MILLIS * 1000);
+}
+
+void Btn::on_settled(void *arg)
+{
+    Btn *self = static_cast<Btn*>(arg);
+    self->settling = false;
+
+    const bool reading = !gpio_ll_get_level(&GPIO, self->gpio_pin);
+    if (reading == self->_pressed) return; // bounced back to where it was
+
+    self->_pressed = reading;
+
+    InputEvent event;
+    event.id = self->id;
+    event.value = reading ? BtnEvent::Press : BtnEvent::Release;
+    event.shifed = self->shift->pressed() ? 1 : 0;
+    event.timestamp_us = self->first_edge_us;
+    xQueueSendToBack(self->queue, &event, 0);
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Arduino.h"
+#include "esp_timer.h"
+#include "events.hpp"
 
 const int BTN_DEBOUNCE_MILLIS = 50;
 
@@ -11,21 +13,32 @@ typedef enum
     Release = 2,
 } BtnEvent;
 
+/**
+ * interrupt driven button: every edge (re)arms a one shot timer, once the level has been
+ * stable for BTN_DEBOUNCE_MILLIS the timer pushes the event stamped with the first edge time
+ */
 struct Btn
 {
 private:
     uint8_t gpio_pin;
+    InputId id;
 
-    long last_down_millis = -1000;
-    bool _pressed = false;
-    bool last_reading = false;
-    BtnEvent _event = BtnEvent::None;
+    QueueHandle_t queue = nullptr;
+    const Btn *shift = nullptr;
+    esp_timer_handle_t debounce_timer = nullptr;
+
+    volatile bool _pressed = false;
+    volatile bool settling = false;
+    volatile uint32_t first_edge_us = 0;
+
+    static void on_edge(void *arg);
+    static void on_settled(void *arg);
 
 public:
-    Btn(uint8_t gpio_pin) : gpio_pin(gpio_pin) {}
-    void begin();
-    void update();
+    Btn(uint8_t gpio_pin, InputId id) : gpio_pin(gpio_pin), id(id) {}
+
+    /** events go to `queue`, flagged as shifted while `shift` is pressed (itself if null) */
+    void begin(QueueHandle_t queue, const Btn *shift = nullptr);
 
-    bool inline pressed() { return _pressed; }
-    BtnEvent inline event() { return _event; }
+    bool inline pressed() const { return _pressed; }
 };
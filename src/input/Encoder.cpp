@@ -1,62 +1,56 @@
 #include "Encoder.hpp"
+#include "hal/gpio_ll.h"
 
-void Encoder::begin()
+// transition (prev_state << 2 | state) -> quarter step, 0 for no change or a skipped state
+static const DRAM_ATTR int8_t QUADRATURE_TABLE[16] = {
+     0, -1,  1,  0,
+     1,  0,  0, -1,
+    -1,  0,  0,  1,
+     0,  1, -1,  0,
+};
+
+void Encoder::begin(QueueHandle_t queue, const Btn *shift)
 {
+    this->queue = queue;
+    this->shift = shift;
+
     pinMode(clk_pin,    INPUT_PULLUP);
     pinMode(dt_pin,     INPUT_PULLUP);
 
     delay(10);
-    last_clk = digitalRead(clk_pin);
+    state = (digitalRead(clk_pin) << 1) | digitalRead(dt_pin);
+
+    attachInterruptArg(clk_pin, &Encoder::on_edge, this, CHANGE);
+    attachInterruptArg(dt_pin,  &Encoder::on_edge, this, CHANGE);
 }
 
-void Encoder::update()
+void IRAM_ATTR Encoder::on_edge(void *arg)
 {
-    const int clk  = digitalRead(clk_pin);
-    const auto now = millis();
-    this->_event = EncoderEvent::None;
-
-    // if (clk == true)
-    // {
-    //     if (this->last_clk == false) // clk low->high
-    //     {
-    //         _last_dt = !digitalRead(dt_pin);
-    //         this->last_down_millis = now;
-    //     }
-    //     else // clk kept high
-    //     {
-    //         if ((now - this->last_down_millis) > ENCODER_DEBOUNCE_MILLIS && !this->_clk_state) // debounce
-    //         {
-    //             this->_clk_state = true; // real state
-
-    //             if(_last_dt != inverted) {
-    //                 this->_event = EncoderEvent::Left;
-    //             }
-    //             else {
-    //                 this->_event = EncoderEvent::Right;
-    //             }
-    //         }
-    //     }
-    // }
-    // else
-    // {
-    //     const bool was_pressed = this->_clk_state;
-    //     this->_clk_state = false;
-    // }
-
-    if(clk != last_clk) {
-        int dt = digitalRead(dt_pin);
-
-        bool is_left = true;
-
-        if (clk) { //raise
-            is_left = dt;
-        }
-        else { //fall
-            is_left = !dt;
-        }
-
-        this->_event = is_left ? EncoderEvent::Left : EncoderEvent::Right;
-    }
-
-    this->last_clk = clk;
+    Encoder *self = static_cast<Encoder*>(arg);
+
+    const int clk = gpio_ll_get_level(&GPIO, self->clk_pin);
+    const int dt  = gpio_ll_get_level(&GPIO, self->dt_pin);
+    const uint8_t new_state = (clk << 1) | dt;
+
+    self->transitions += QUADRATURE_TABLE[(self->state << 2) | new_state];
+    self->state = new_state;
+
+    // only count on detents, a half way bounce never gets here
+    if (clk != dt) return;
+
+    const int8_t transitions = self->transitions;
+    self->transitions = 0;
+    if (transitions > -2 && transitions < 2) return;
+
+    const bool is_left = transitions < 0;
+
+    InputEvent event;
+    event.id = self->id;
+    event.value = (is_left != self->inverted) ? EncoderEvent::Left : EncoderEvent::Right;
+    event.shifed = self->shift->pressed() ? 1 : 0;
+    event.timestamp_us = (uint32_t)esp_timer_get_time();
+
+    BaseType_t woken = pdFALSE;
+    xQueueSendToBackFromISR(self->queue, &event, &woken);
+    if (woken) portYIELD_FROM_ISR();
 }
@@ -1,8 +1,8 @@
 #pragma once
 
 #include "Arduino.h"
-
-const int ENCODER_DEBOUNCE_MILLIS = 9;
+#include "events.hpp"
+#include "Btn.hpp"
 
 namespace EncoderEvent{
     typedef enum
@@ -13,27 +13,33 @@ namespace EncoderEvent{
     } Value;
 };
 
+/**
+ * interrupt driven quadrature decoder, both pins fire on change.
+ * contact bounce shows up as a back and forth transition and cancels out,
+ * a step is pushed each time the encoder lands on a detent (clk == dt)
+ */
 struct Encoder
 {
 private:
     uint8_t clk_pin;
     uint8_t dt_pin;
+    InputId id;
+
+    QueueHandle_t queue = nullptr;
+    const Btn *shift = nullptr;
 
-    long last_down_millis = -1000;
-    bool _clk_state = false;
-    int _last_dt = 0;
-    bool last_clk = false;
-    EncoderEvent::Value _event = EncoderEvent::None;
+    volatile uint8_t state = 0;     // (clk << 1) | dt
+    volatile int8_t  transitions = 0;
+
+    static void on_edge(void *arg);
 
 public:
     bool inverted;
 
-    Encoder(uint8_t clk_pin, uint8_t dt_pin, bool inverted = false) 
-        : clk_pin(clk_pin), dt_pin(dt_pin), inverted(inverted)
+    Encoder(uint8_t clk_pin, uint8_t dt_pin, InputId id, bool inverted = false) 
+        : clk_pin(clk_pin), dt_pin(dt_pin), id(id), inverted(inverted)
     {}
 
-    void begin();
-    void update();
-
-    EncoderEvent::Value inline event() { return _event; }
+    /** steps go to `queue`, flagged as shifted while `shift` is pressed */
+    void begin(QueueHandle_t queue, const Btn *shift);
 };
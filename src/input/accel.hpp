@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "events.hpp"
+
+struct AccelStep {
+    uint32_t max_interval_us;
+    int16_t  mult;
+};
+
+/** step multiplier by time since the previous detent, first match wins */
+static const AccelStep ENCODER_ACCEL_STEPS[] = {
+    {  8000, 8 },
+    { 16000, 4 },
+    { 32000, 2 },
+};
+
+/** scales encoder steps by turning speed, a pause or a change of direction starts over at 1x */
+struct EncoderAccel {
+    uint32_t last_us = 0;
+    int16_t  last_dir = 0;
+
+    int16_t apply(int16_t dir, uint32_t timestamp_us) {
+        const uint32_t interval = timestamp_us - last_us;
+        const bool same_dir = (dir > 0) == (last_dir > 0) && last_dir != 0;
+        last_us = timestamp_us;
+        last_dir = dir;
+
+        if(!same_dir) return dir;
+
+        for(const auto &step : ENCODER_ACCEL_STEPS) {
+            if(interval <= step.max_interval_us) return dir * step.mult;
+        }
+        return dir;
+    }
+};
+
+
+/**
+ * drains the input queue once per ui frame: consecutive steps of the same encoder on the same layer
+ * are accelerated and merged into a single event, everything else is passed through in order
+ */
+class InputCoalescer {
+public:
+    template<typename Handler>
+    void drain(QueueHandle_t queue, Handler handle) {
+        InputEvent event;
+        InputEvent pending;
+        bool has_pending = false;
+
+        while(xQueueReceive(queue, &event, 0) == pdTRUE) {
+            const int encoder = encoder_index(event.id);
+
+            if(encoder >= 0) {
+                event.value = accel[encoder].apply(event.value, event.timestamp_us);
+
+                if(has_pending && pending.id == event.id && pending.shifed == event.shifed) {
+                    pending.value += event.value;
+                    continue;
+                }
+            }
+
+            if(has_pending) handle(pending);
+            has_pending = encoder >= 0;
+
+            if(has_pending) pending = event;
+            else            handle(event);
+        }
+
+        if(has_pending) handle(pending);
+    }
+
+private:
+    static constexpr int ENCODER_COUNT = 3;
+    EncoderAccel accel[ENCODER_COUNT];
+
+    static int encoder_index(InputId id) {
+        const int index = (int)id - (int)InputId::Encoder0;
+        return index >= 0 && index < ENCODER_COUNT ? index : -1;
+    }
+};
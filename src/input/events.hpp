@@ -30,4 +30,5 @@ struct __attribute__((packed)) InputEvent {
     InputId id = InputId::None;
     int16_t value = 0;
     uint8_t shifed = 0;
+    uint32_t timestamp_us = 0;  // esp_timer time of the edge that caused it
 };
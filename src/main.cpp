@@ -9,6 +9,7 @@
 #include "driver/uart.h"
 #include "driver/gpio.h"
 #include "driver/i2s.h"
+#include "driver/i2c.h"
 
 #include "Wire.h"
 #include "Adafruit_GFX.h"
@@ -20,14 +21,44 @@
 #include "audio/midi.hpp"
 #include "audio/wavetable.hpp"
 #include "comms/uart_rx.hpp"
+#include "comms/ble_midi.hpp"
+#include "comms/log_sink.hpp"
 #include "input/events.hpp"
 #include "input/Btn.hpp"
 #include "input/Encoder.hpp"
+#include "input/accel.hpp"
 #include "ui/UiController.hpp"
+#include "ui/display.hpp"
+#include "ui/frame.hpp"
 #include "remote/remote.hpp"
+#include "remote/params.hpp"
+#include "storage/patches.hpp"
+#include "memory/arena.hpp"
+#include "memory/alloc_guard.hpp"
+#include "memory/spsc_ring.hpp"
+#include "diag/monitor.hpp"
 
-QueueHandle_t midi_event_queue;
 QueueHandle_t input_event_queue;
+QueueHandle_t param_request_queue;
+QueueHandle_t midi_control_queue;
+QueueHandle_t uart_event_queue;
+
+// notes to the audio task, one ring per producer task so neither side takes a lock
+using MidiRing = SpscRing<TimedMidiEvent, MIDI_EVENTS_QUEUE_SIZE>;
+static MidiRing uart_midi_ring;
+static MidiRing ble_midi_ring;
+
+/** program and control changes go to the ui task, it owns the patches and the parameters */
+static void queue_midi_event(MidiRing &ring, const TimedMidiEvent &event) {
+    switch(event.event.get_event_type()) {
+        case MidiEventType::ProgramChange:
+        case MidiEventType::ControlChange:
+            xQueueSendToBack(midi_control_queue, &event.event, 0);
+            break;
+        default:
+            ring.push(event);
+    }
+}
 
 // ─────────────────────────────────────────────────────────────
 // ||   TASK: UART RX (for midi notes only)
@@ -35,47 +66,84 @@ QueueHandle_t input_event_queue;
 namespace PacketType {
     enum Value {
         Midi = 0xA0,
+        MidiBatch = 0xA1,   // MidiBatchEntry[n], chords and arp steps in one frame
         Log = 0xF0,
     };
 }
 
+struct __attribute__((packed)) MidiBatchEntry {
+    uint16_t  delta_us;     // since the previous event of the batch at the sender, 0 for the first
+    MidiEvent event;
+};
+
+static void handle_packet(const Packet &packet) {
+    switch(packet.type) {
+        case PacketType::Midi: {
+            TimedMidiEvent midi_event = { MidiEvent(packet.payload), (uint32_t)esp_timer_get_time() };
+            queue_midi_event(uart_midi_ring, midi_event);
+            break;
+        }
+        case PacketType::MidiBatch: {
+            // the first event sounds on arrival, the others keep the spacing they were sent with
+            TimedMidiEvent midi_event = { MidiEvent(), (uint32_t)esp_timer_get_time() };
+            MidiBatchEntry entry;
+
+            for(size_t i = 0; i + sizeof(entry) <= packet.payload_len; i += sizeof(entry)) {
+                memcpy(&entry, packet.payload + i, sizeof(entry));
+                midi_event.event = entry.event;
+                midi_event.time_us += entry.delta_us;
+                queue_midi_event(uart_midi_ring, midi_event);
+            }
+            break;
+        }
+        case PacketType::Log: {
+            log_sink::push(packet.payload, packet.payload_len);
+            break;
+        }
+    }
+}
+
 static void rx_task(void *arg)
 {
     static const char *RX_TASK_TAG = "RX_TASK";
     esp_log_level_set(RX_TASK_TAG, ESP_LOG_INFO);
     
-    uint8_t* data = (uint8_t*) malloc(UART_RX_BUFFER_SIZE);
-    PacketDecoder decoder;
-    Packet packet;
+    uint8_t* data = memory::runtime().alloc_array<uint8_t>(UART_RX_BUFFER_SIZE);
+    assert(data != nullptr);
+    static PacketDecoder decoder;
+    uart_event_t event;
+
+    log_sink::watch_decoder(&decoder.errors());
+    alloc_guard::watch_current_task();
 
     while (true) {
-        const size_t rx_bytes = uart_read_bytes(UART_NUM_1, data, UART_RX_BUFFER_SIZE, 0);
-
-        for(size_t i = 0; i < rx_bytes; i++) {                
-            bool has_packet = decoder.decode(data[i], &packet);
-            
-            if(has_packet) {
-                switch(packet.type) {
-                    case PacketType::Midi: {
-                        MidiEvent midi_event(packet.payload);
-                        xQueueGenericSend(midi_event_queue, &midi_event, 0, queueSEND_TO_BACK);
-                        break;
-                    }
-                    case PacketType::Log: {
-                        Serial.print("UART LOG: ");
-                        char buffer[PacketDecoder::MAX_PAYLOAD_LEN*2] = {0};
-                        strncpy(buffer, (char*)packet.payload, packet.payload_len);
-                        buffer[packet.payload_len] = '\0';
-                        Serial.println(buffer);
-                        break;
-                    }
-                }
+        // sleeps until the driver reports data: fifo threshold, or rx timeout at the end of a burst
+        if(xQueueReceive(uart_event_queue, &event, portMAX_DELAY) != pdTRUE) continue;
+
+        switch(event.type) {
+            case UART_DATA: {
+                // one event can cover several chunks, the whole backlog is decoded before sleeping again
+                size_t pending = 0;
+                uart_get_buffered_data_len(UART_NUM_1, &pending);
+
+                decode_chunks(decoder, data, UART_RX_BUFFER_SIZE, pending, [](uint8_t *buffer, size_t len) {
+                    return uart_read_bytes(UART_NUM_1, buffer, len, 0);
+                }, handle_packet);
+                break;
+            }
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL: {
+                // the stream has a hole, resync on the next delimiter
+                ESP_LOGW(RX_TASK_TAG, "rx overflow, input dropped");
+                uart_flush_input(UART_NUM_1);
+                xQueueReset(uart_event_queue);
+                decoder.reset();
+                break;
             }
+            default:
+                break;
         }
-
-        delay(1);
     }
-    free(data);
 }
 
 
@@ -84,36 +152,39 @@ static void rx_task(void *arg)
 // ─────────────────────────────────────────────────────────────
 Synth synth;
 
+/**
+ * layout for I2S_CHANNEL_FMT_RIGHT_LEFT at 16 bit: the esp32 shifts out the upper half-word first,
+ * so the left slot lives in the second field
+ */
 struct __attribute__((packed)) AudioFrame {
-    int16_t ch1;
-    int16_t ch2;
+    int16_t right;
+    int16_t left;
 
     static const int16_t MAX = INT16_MAX / 2; 
 };
 
+// one ble-midi packet must fit whole, otherwise its tail waits in the ring behind the next blocks
+static_assert(MIDI_SCHEDULER_SIZE >= BLE_MIDI_MAX_EVENTS, "scheduler smaller than a ble-midi packet");
+
 static void i2s_task(void *arg) {
     AudioFrame frames[SYNTH_CHUNK_SIZE] = {0};
-    float synth_buffer[SYNTH_CHUNK_SIZE] = {0};
+    StereoSample synth_buffer[SYNTH_CHUNK_SIZE] = {};
 
-    MidiEvent midi_event;
+    MidiScheduler scheduler;
 
-    while(true) {
-        // process midi events
-        while(xQueueReceive(midi_event_queue, &midi_event, 0) == pdTRUE) {
-            synth.process_midi_event(midi_event);
-            // ESP_LOGE("I2S_TASK", "midi event: %02X %02X %02X %02X", midi_event.header, midi_event.status, midi_event.data1, midi_event.data2);
-        }
+    alloc_guard::watch_current_task();
 
-        // process synth audio
+    while(true) {
+        // collect midi events, then render the block split where they fall
+        scheduler.collect(uart_midi_ring, ble_midi_ring);
         // START_PERF(synth_loop);
-        memset(synth_buffer, 0.f, SYNTH_CHUNK_SIZE * sizeof(float));
-        synth.process_block(synth_buffer, SYNTH_CHUNK_SIZE);
+        synth.render_chunk(synth_buffer, scheduler, esp_timer_get_time());
         // STOP_PERF(synth_loop, 300);
 
         // set frame data
         for(size_t i = 0; i < SYNTH_CHUNK_SIZE; i++) {
-            frames[i].ch1 = synth_buffer[i] * AudioFrame::MAX;
-            frames[i].ch2 = synth_buffer[i] * AudioFrame::MAX;
+            frames[i].right = synth_buffer[i].right * AudioFrame::MAX;
+            frames[i].left  = synth_buffer[i].left  * AudioFrame::MAX;
         }
 
         // write to i2s
@@ -132,42 +203,80 @@ static void i2s_task(void *arg) {
 // ─────────────────────────────────────────────────────────────
 // ||   TASK: DISPLAY
 // ─────────────────────────────────────────────────────────────
-Adafruit_SSD1306 display(128, 64, &Wire);
+// parameter replies go back where the request came from
+static void serial_param_send(const uint8_t *data, size_t len) {
+    Serial.print("PARAM:");
+    for(size_t i = 0; i < len; i++) Serial.printf(" %02x", data[i]);
+    Serial.println();
+}
+
+static ParamReply param_reply(uint8_t source) {
+    if(source == ParamSource::Serial) return { serial_param_send, PARAM_REQUEST_MAX };
+    return { remote::send_params, remote::notify_capacity() };
+}
+
+Adafruit_SSD1306 display(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire, -1, DISPLAY_I2C_CLOCK_HZ, DISPLAY_I2C_CLOCK_HZ);
+I2cDisplayBus display_bus(I2C_NUM_0, DISPLAY_I2C_ADDR);   // wire runs on port 0
 
 
 void display_task(void *arg) {
     display.setTextColor(SSD1306_WHITE); // Draw white text
     display.setTextWrap(false);
     display.setCursor(0, 0);
-    display.display();
 
     UiController controller(&display);
     controller.init();
+    patches::load(controller, patches::begin());    // defaults stay when the slot is empty
+
+    static uint8_t glyphs[GLYPH_DICT_SIZE];
+    remote::set_glyph_dictionary(glyphs, controller.render_glyphs(glyphs, sizeof(glyphs)));
     synth.update_config(controller.config);
 
-    InputEvent event;
+    InputCoalescer coalescer;
+    static FrameManager frames;
 
     while(true) {
-        // copy to for comparison
-        const auto old_config = controller.config;
+        // control changes move the mapped parameter, program changes recall a patch slot
+        // and the synth glides there instead of jumping
+        MidiEvent control;
+        while(xQueueReceive(midi_control_queue, &control, 0) == pdTRUE) {
+            if(control.get_event_type() == MidiEventType::ControlChange) {
+                controller.control_change(control.get_control(), control.get_control_value());
+            }
+            else if(patches::load(controller, control.get_program()) && controller.sync()) {
+                synth.update_config(controller.config, PRESET_MORPH_SECS);
+            }
+        }
 
-        // process events
-        while(xQueueReceive(input_event_queue, &event, 0) == pdTRUE) {
+        // process events, encoder bursts arrive merged into one accelerated step
+        coalescer.drain(input_event_queue, [&](const InputEvent &event) {
             controller.process_event(event);
-        }
+        });
 
-        // check for change by memory comparison
-        bool config_changed = 0 != memcmp(&old_config, &controller.config, sizeof(SynthConfig));
-        if(config_changed) {
-            synth.update_config(controller.config); 
+        // remote parameter requests, the widgets are only touched from this task
+        static ParamRequest request;
+        while(xQueueReceive(param_request_queue, &request, 0) == pdTRUE) {
+            params::handle(controller, request, param_reply(request.source));
         }
 
-        display.clearDisplay();
-        if(controller.render_to_buffer()) {
-            display.display();
+        // one pass over the flat parameters finds what changed, from any source
+        if(controller.sync()) {
+            synth.update_config(controller.config);
+        }
+        params::notify_changes(controller, param_reply(ParamSource::Ble));
+        patches::poll(controller, !synth.is_sounding());
+
+        // idle frames touch neither the bus nor the remote, the transfer itself runs in flush_task
+        DirtyRegion region;
+        FrameDiff diff;
+        if(controller.render_to_buffer(region)) {
+            diff = frames.commit(display.getBuffer());
         }
 
-        remote::send_screen(display.getBuffer());
+        if(!diff.empty()) {
+            oled::submit(frames.front(), diff.region);
+            remote::send_screen(frames.front(), diff.pages());
+        }
 
         delay(20); // 50hz
     }
@@ -175,76 +284,14 @@ void display_task(void *arg) {
 
 
 // ─────────────────────────────────────────────────────────────
-// ||   TASK: INPUT
+// ||   INPUT (interrupt driven, no task)
 // ─────────────────────────────────────────────────────────────
-Btn btn_lx(5);
-Btn btn_rx(33);
-Btn btn_shift(32);
-Encoder encoder_0(17, 4, false);
-Encoder encoder_1(19, 18, false);
-Encoder encoder_2(13, 23, false);
-
-
-void input_task(void *arg) {
-    btn_lx.begin();
-    btn_rx.begin();
-    btn_shift.begin();
-    encoder_0.begin();
-    encoder_1.begin();
-    encoder_2.begin();
-
-    delay(100); // wait for inputs to stabilize (due to internal pullup)
-
-    while(true) {
-        btn_lx.update();
-        btn_rx.update();
-        btn_shift.update();
-        encoder_0.update();
-        encoder_1.update();
-        encoder_2.update();
-
-        InputEvent event;
-        event.shifed = btn_shift.pressed() ? 1 : 0;
-
-        if(btn_lx.event()) {
-            event.id = InputId::BtnLx;
-            event.value = btn_lx.event();
-            xQueueSendToBack(input_event_queue, &event, 0);
-        }
-
-        if(btn_rx.event()) {
-            event.id = InputId::BtnRx;
-            event.value = btn_rx.event();
-            xQueueSendToBack(input_event_queue, &event, 0);
-        }
-
-        if(btn_shift.event()) {
-            event.id = InputId::BtnShift;
-            event.value = btn_shift.event();
-            xQueueSendToBack(input_event_queue, &event, 0);
-        }
-
-        if(encoder_0.event()) {
-            event.id = InputId::Encoder0;
-            event.value = encoder_0.event();
-            xQueueSendToBack(input_event_queue, &event, 0);
-        }
-
-        if(encoder_1.event()) {
-            event.id = InputId::Encoder1;
-            event.value = encoder_1.event();
-            xQueueSendToBack(input_event_queue, &event, 0);
-        }
-
-        if(encoder_2.event()) {
-            event.id = InputId::Encoder2;
-            event.value = encoder_2.event();
-            xQueueSendToBack(input_event_queue, &event, 0);
-        }
-
-        delay(5); // 200hz
-    }
-}
+Btn btn_lx(5,     InputId::BtnLx);
+Btn btn_rx(33,    InputId::BtnRx);
+Btn btn_shift(32, InputId::BtnShift);
+Encoder encoder_0(17, 4,  InputId::Encoder0, false);
+Encoder encoder_1(19, 18, InputId::Encoder1, false);
+Encoder encoder_2(13, 23, InputId::Encoder2, false);
 
 
 // ─────────────────────────────────────────────────────────────
@@ -254,6 +301,34 @@ static void on_remote_input(const InputEvent &event) {
     xQueueSendToBack(input_event_queue, &event, pdMS_TO_TICKS(200));
 }
 
+/** ble-midi packets, every message of a packet is queued together with its own time */
+static void on_remote_midi(const uint8_t *data, size_t len, uint32_t arrival_us) {
+    static BleMidiDecoder decoder;
+    static BleMidiClock clock;
+    static TimedMidiEvent batch[BLE_MIDI_MAX_EVENTS];
+    static uint16_t timestamps[BLE_MIDI_MAX_EVENTS];
+    size_t count = 0;
+
+    decoder.decode(data, len, [&](const MidiEvent &event, uint16_t timestamp) {
+        if(count >= BLE_MIDI_MAX_EVENTS) return;
+        batch[count].event = event;
+        timestamps[count++] = timestamp;
+    });
+    if(count == 0) return;
+
+    // the last message was written closest to the send time, it tracks the offset best
+    clock.observe(timestamps[count - 1], arrival_us);
+
+    for(size_t i = 0; i < count; i++) {
+        batch[i].time_us = clock.to_local_us(timestamps[i], arrival_us, BLE_MIDI_JITTER_MS);
+        queue_midi_event(ble_midi_ring, batch[i]);
+    }
+}
+
+static void on_remote_params(const ParamRequest &request) {
+    xQueueSendToBack(param_request_queue, &request, 0);
+}
+
 
 // ─────────────────────────────────────────────────────────────
 // ||   MAIN
@@ -261,23 +336,25 @@ static void on_remote_input(const InputEvent &event) {
 void setup() {
     Serial.begin(115200);
 
-    midi_event_queue =  xQueueCreate(MIDI_EVENTS_QUEUE_SIZE,  sizeof(MidiEvent));
     input_event_queue = xQueueCreate(INPUT_EVENTS_QUEUE_SIZE, sizeof(InputEvent));
+    param_request_queue = xQueueCreate(PARAM_QUEUE_SIZE, sizeof(ParamRequest));
+    midi_control_queue = xQueueCreate(MIDI_CONTROL_QUEUE_SIZE, sizeof(MidiEvent));
 
     // ---- UART SETUP ----
     const uart_config_t uart_config = {
-        .baud_rate = 115200,
+        .baud_rate = UART_BAUD_RATE,
         .data_bits = UART_DATA_8_BITS,
         .parity = UART_PARITY_DISABLE,
         .stop_bits = UART_STOP_BITS_1,
         .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
         // .source_clk = UART_SCLK_DEFAULT,
     };
-    uart_driver_install(UART_NUM_1, UART_RX_BUFFER_SIZE * 2, 0, 0, NULL, 0);
+    log_sink::begin();
+    uart_driver_install(UART_NUM_1, UART_RX_RING_SIZE, 0, UART_EVENT_QUEUE_SIZE, &uart_event_queue, 0);
     uart_param_config(UART_NUM_1, &uart_config);
     uart_set_pin(UART_NUM_1, PIN_UART_TX, PIN_UART_RX, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
-    uart_set_rx_full_threshold(UART_NUM_1, 64); // reduce latency
-    uart_set_rx_timeout(UART_NUM_1, 1); // reduce latency
+    uart_set_rx_full_threshold(UART_NUM_1, 64); // an event every half fifo during long bursts
+    uart_set_rx_timeout(UART_NUM_1, 2);         // and 2 symbols after the last byte, ends every packet
 
     // ---- I2S SETUP ----
     const i2s_pin_config_t i2s_pin_config = {
@@ -306,24 +383,85 @@ void setup() {
 
     // ---- DISPLAY SETUP ----
     Wire.begin(PIN_I2C_SDA, PIN_I2C_SCK);
-    display.begin(SSD1306_SWITCHCAPVCC, 0x3C); // Address 0x3C for 128x64
+    display.begin(SSD1306_SWITCHCAPVCC, DISPLAY_I2C_ADDR);
     display.clearDisplay();
     display.display();
+    oled::begin(&display_bus);
 
     // ---- SYNTH SETUP ----
     synth.begin();
 
+    // ---- INPUT SETUP ----
+    btn_shift.begin(input_event_queue);
+    btn_lx.begin(input_event_queue, &btn_shift);
+    btn_rx.begin(input_event_queue, &btn_shift);
+    encoder_0.begin(input_event_queue, &btn_shift);
+    encoder_1.begin(input_event_queue, &btn_shift);
+    encoder_2.begin(input_event_queue, &btn_shift);
+
     // ---- REMOTE SETUP ----
     remote::init();
     remote::set_input_cb(on_remote_input);
+    remote::set_param_cb(on_remote_params);
+    remote::set_midi_cb(on_remote_midi);
 
     // ---- TASKS ----
+    TaskHandle_t rx_handle, display_handle, flush_handle, log_handle, i2s_handle, screen_handle;
     // core 1
-    xTaskCreatePinnedToCore(input_task,   "input_task",     4096, NULL,     configMAX_PRIORITIES - 1, NULL, 1);
-    xTaskCreatePinnedToCore(rx_task,      "uart_rx_task",   4096, NULL,     configMAX_PRIORITIES - 3, NULL, 1);
-    xTaskCreatePinnedToCore(display_task, "display_task",   4096, NULL,     1,                        NULL, 1);
+    xTaskCreatePinnedToCore(rx_task,      "uart_rx_task",   TASK_STACK_UART_RX, NULL,   configMAX_PRIORITIES - 3, &rx_handle,      1);
+    xTaskCreatePinnedToCore(display_task, "display_task",   TASK_STACK_DISPLAY, NULL,   1,                        &display_handle, 1);
+    xTaskCreatePinnedToCore(oled::flush_task, "flush_task", TASK_STACK_FLUSH,   NULL,   2,                        &flush_handle,   1);
+    xTaskCreatePinnedToCore(log_sink::drain_task, "log_task", TASK_STACK_LOG,   NULL,   1,                        &log_handle,     1);
     // core 0
-    xTaskCreatePinnedToCore(i2s_task,     "i2s_task",       4096, NULL,     configMAX_PRIORITIES - 1, NULL, 0);
+    xTaskCreatePinnedToCore(i2s_task,     "i2s_task",       TASK_STACK_I2S,     NULL,   configMAX_PRIORITIES - 1, &i2s_handle,     0);
+    xTaskCreatePinnedToCore(remote::screen_task, "screen_task", TASK_STACK_SCREEN, NULL,   1,                        &screen_handle,  0);
+
+    // ---- MONITOR ----
+    monitor::watch(rx_handle,      TASK_STACK_UART_RX, 1);
+    monitor::watch(display_handle, TASK_STACK_DISPLAY, 1);
+    monitor::watch(flush_handle,   TASK_STACK_FLUSH,   1);
+    monitor::watch(log_handle,     TASK_STACK_LOG,     1);
+    monitor::watch(i2s_handle,     TASK_STACK_I2S,     0);
+    monitor::watch(screen_handle,  TASK_STACK_SCREEN,  0);
+    monitor::begin();
+
+    // from here on the audio and midi paths must not touch the heap
+    alloc_guard::arm();
+}
+
+#ifdef PARAM_SERIAL_CLIENT
+/** stand-in for the ble client: one request per line as hex bytes ("02 01 01 01 00 02 00 00"), replies print as PARAM: */
+static void serial_param_client() {
+    static ParamRequest request = { ParamSource::Serial, 0, {0} };
+    static int8_t high_nibble = -1;
+
+    while(Serial.available()) {
+        const char c = Serial.read();
+
+        if(c == '\n') {
+            if(request.len) xQueueSendToBack(param_request_queue, &request, 0);
+            request.len = 0;
+            high_nibble = -1;
+            continue;
+        }
+
+        const int8_t nibble = (c >= '0' && c <= '9') ? c - '0'
+                            : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                            : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        if(nibble < 0) continue;
+
+        if(high_nibble < 0) high_nibble = nibble;
+        else {
+            if(request.len < sizeof(request.data)) request.data[request.len++] = high_nibble << 4 | nibble;
+            high_nibble = -1;
+        }
+    }
 }
 
+void loop() {
+    serial_param_client();
+    delay(10);
+}
+#else
 void loop() { delay(1000); }
+#endif
@@ -0,0 +1,62 @@
+#include "alloc_guard.hpp"
+
+#ifdef ALLOC_GUARD
+#include <cstdlib>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_rom_sys.h"
+
+#define ALLOC_GUARD_MAX_TASKS 8
+
+static volatile bool s_armed = false;
+static TaskHandle_t s_watched[ALLOC_GUARD_MAX_TASKS] = { nullptr };
+static volatile size_t s_watched_count = 0;
+static portMUX_TYPE s_watch_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void alloc_guard::watch_current_task() {
+    portENTER_CRITICAL(&s_watch_mux);
+    if(s_watched_count < ALLOC_GUARD_MAX_TASKS)
+        s_watched[s_watched_count++] = xTaskGetCurrentTaskHandle();
+    portEXIT_CRITICAL(&s_watch_mux);
+}
+
+void alloc_guard::arm() {
+    s_armed = true;
+}
+
+static void check(const char *fn, size_t size) {
+    if(!s_armed) return;
+
+    const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    for(size_t i = 0; i < s_watched_count; i++) {
+        if(s_watched[i] == task) {
+            // no ESP_LOG here: it could allocate itself
+            esp_rom_printf("ALLOC_GUARD: %s(%d) from task '%s' after boot\n", fn, size, pcTaskGetName(task));
+            abort();
+        }
+    }
+}
+
+extern "C" {
+    void *__real_malloc(size_t size);
+    void *__real_calloc(size_t n, size_t size);
+    void *__real_realloc(void *ptr, size_t size);
+
+    void *__wrap_malloc(size_t size) {
+        check("malloc", size);
+        return __real_malloc(size);
+    }
+
+    void *__wrap_calloc(size_t n, size_t size) {
+        check("calloc", n * size);
+        return __real_calloc(n, size);
+    }
+
+    void *__wrap_realloc(void *ptr, size_t size) {
+        check("realloc", size);
+        return __real_realloc(ptr, size);
+    }
+}
+
+#endif
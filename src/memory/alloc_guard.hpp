@@ -0,0 +1,18 @@
+#pragma once
+
+/**
+ * debug mode for deterministic memory after boot, enabled by -DALLOC_GUARD with malloc/calloc/realloc
+ * wrapped at link time (see the esp32dev-allocguard env).
+ * once armed, any heap allocation from a watched task prints the offender and aborts.
+ * without ALLOC_GUARD every call compiles to nothing
+ */
+namespace alloc_guard {
+#ifdef ALLOC_GUARD
+    /** the calling task must not allocate after arm(), call it once its buffers are set up */
+    void watch_current_task();
+    void arm();
+#else
+    inline void watch_current_task() {}
+    inline void arm() {}
+#endif
+};
@@ -0,0 +1,17 @@
+#include "arena.hpp"
+#include "config.h"
+
+void *Arena::alloc(size_t bytes, size_t align) {
+    const size_t start = (_used + align - 1) & ~(align - 1);
+    if(region == nullptr || start + bytes > size) return nullptr;
+
+    _used = start + bytes;
+    return region + start;
+}
+
+
+static StaticArena<RUNTIME_ARENA_SIZE> s_runtime_arena;
+
+Arena &memory::runtime() {
+    return s_runtime_arena;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * bump allocator over a fixed region: allocations live until reboot and nothing is freed,
+ * so memory use is fully known once the tasks are started
+ */
+class Arena {
+public:
+    Arena() = default;
+    Arena(uint8_t *region, size_t size) : region(region), size(size) {}
+
+    /** nullptr when the arena is full */
+    void *alloc(size_t bytes, size_t align = 4);
+
+    template<typename T>
+    T *alloc_array(size_t count) {
+        return static_cast<T*>(alloc(count * sizeof(T), alignof(T)));
+    }
+
+    bool   valid()    const { return region != nullptr; }
+    size_t used()     const { return _used; }
+    size_t capacity() const { return size; }
+
+private:
+    uint8_t *region = nullptr;
+    size_t size = 0;
+    size_t _used = 0;
+};
+
+
+template<size_t N>
+class StaticArena : public Arena {
+public:
+    StaticArena() : Arena(storage, N) {}
+
+private:
+    alignas(8) uint8_t storage[N];
+};
+
+
+namespace memory {
+    /** shared arena for task buffers, sized by RUNTIME_ARENA_SIZE */
+    Arena &runtime();
+};
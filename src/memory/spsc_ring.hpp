@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+#define SPSC_ALIGN 32   // keeps the producer and consumer indices on separate lines
+
+/**
+ * single producer, single consumer ring: no locks and no critical sections, so it can cross cores.
+ * each side only writes its own index, the other one is read with acquire ordering.
+ * N must be a power of two, one slot stays empty to tell full from empty
+ */
+template<typename T, size_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+    /** producer side, false when full */
+    bool push(const T &item) {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        const size_t next = (head + 1) & (N - 1);
+        if(next == _tail.load(std::memory_order_acquire)) return false;
+
+        items[head] = item;
+        _head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /** consumer side, false when empty */
+    bool pop(T *item) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if(tail == _head.load(std::memory_order_acquire)) return false;
+
+        *item = items[tail];
+        _tail.store((tail + 1) & (N - 1), std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return _tail.load(std::memory_order_acquire) == _head.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(SPSC_ALIGN) std::atomic<size_t> _head { 0 };   // written by the producer
+    alignas(SPSC_ALIGN) std::atomic<size_t> _tail { 0 };   // written by the consumer
+    alignas(SPSC_ALIGN) T items[N];
+};
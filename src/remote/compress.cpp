@@ -1,20 +1,26 @@
 #include "compress.hpp"
 
-void bit_rle_compress(const uint8_t *src, size_t src_len, uint8_t *dest, size_t *dest_len) {
-    size_t write_index = 0;
-    size_t bit_index = 0;
-    uint8_t current_bit = (src[0] >> 7) & 1;
-    uint8_t run_length = 0;
-
-    if (dest == NULL || dest_len == NULL || src == NULL || src_len == 0) {
+// ------- BIT RLE --------
+void bit_rle_compress(const uint8_t *src, size_t src_len, uint8_t *dest, size_t *dest_len, size_t dest_cap) {
+    if (dest == NULL || dest_len == NULL || src == NULL || src_len == 0 || dest_cap == 0) {
         if (dest_len) *dest_len = 0;
         return;
     }
 
+    size_t write_index = 0;
+    uint8_t current_bit = (src[0] >> 7) & 1;
+    uint8_t run_length = 0;
+
     dest[write_index++] = current_bit;  // store starting bit
 
     for (size_t byte = 0; byte < src_len; ++byte) {
         for (int bit = 7; bit >= 0; --bit) {
+            // one more run might still be written after this one
+            if (write_index + 1 >= dest_cap) {
+                *dest_len = 0;
+                return;
+            }
+
             uint8_t b = (src[byte] >> bit) & 1;
             if (b == current_bit) {
                 run_length++;
@@ -36,3 +42,262 @@ void bit_rle_compress(const uint8_t *src, size_t src_len, uint8_t *dest, size_t
 
     *dest_len = write_index;
 }
+
+size_t bit_rle_decompress(const uint8_t *src, size_t src_len, uint8_t *dest, size_t dest_cap) {
+    if (src == NULL || dest == NULL || src_len == 0) return 0;
+
+    uint8_t current_bit = src[0] & 1;
+    size_t bit_index = 0;
+
+    for (size_t i = 1; i < src_len; i++) {
+        const uint8_t run_length = src[i];
+        if (bit_index + run_length > dest_cap * 8) return 0;
+
+        for (size_t r = 0; r < run_length; r++, bit_index++) {
+            const uint8_t mask = 0x80 >> (bit_index & 7);
+            if (current_bit) dest[bit_index >> 3] |= mask;
+            else             dest[bit_index >> 3] &= ~mask;
+        }
+
+        // a full run continues with the same bit
+        if (run_length != 255) current_bit ^= 1;
+    }
+
+    return bit_index % 8 == 0 ? bit_index / 8 : 0;
+}
+
+
+// ------- PACKBITS --------
+size_t packbits_compress(const uint8_t *src, size_t src_len, uint8_t *dest, size_t dest_cap) {
+    size_t write_index = 0;
+    size_t read_index = 0;
+
+    while (read_index < src_len) {
+        size_t run_length = 1;
+        while (read_index + run_length < src_len && src[read_index + run_length] == src[read_index] && run_length < 128)
+            run_length++;
+
+        // repeat: 257 - n copies of the next byte
+        if (run_length >= 2) {
+            if (write_index + 2 > dest_cap) return 0;
+            dest[write_index++] = (uint8_t)(257 - run_length);
+            dest[write_index++] = src[read_index];
+            read_index += run_length;
+            continue;
+        }
+
+        // literal: n + 1 bytes, ends where the next repeat starts
+        size_t literal_len = 1;
+        while (read_index + literal_len < src_len && literal_len < 128) {
+            const size_t i = read_index + literal_len;
+            if (i + 1 < src_len && src[i] == src[i + 1]) break;
+            literal_len++;
+        }
+
+        if (write_index + 1 + literal_len > dest_cap) return 0;
+        dest[write_index++] = (uint8_t)(literal_len - 1);
+        for (size_t i = 0; i < literal_len; i++) dest[write_index++] = src[read_index++];
+    }
+
+    return write_index;
+}
+
+size_t packbits_decompress(const uint8_t *src, size_t src_len, uint8_t *dest, size_t dest_cap) {
+    size_t write_index = 0;
+    size_t read_index = 0;
+
+    while (read_index < src_len) {
+        const uint8_t header = src[read_index++];
+
+        if (header < 128) {
+            const size_t literal_len = header + 1;
+            if (read_index + literal_len > src_len || write_index + literal_len > dest_cap) return 0;
+            for (size_t i = 0; i < literal_len; i++) dest[write_index++] = src[read_index++];
+        }
+        else if (header > 128) {
+            const size_t run_length = 257 - header;
+            if (read_index >= src_len || write_index + run_length > dest_cap) return 0;
+            for (size_t i = 0; i < run_length; i++) dest[write_index++] = src[read_index];
+            read_index++;
+        }
+    }
+
+    return write_index;
+}
+
+
+// ------- LZ --------
+// token 0lllllll: l + 1 literals follow
+// token 1ooLLLLL + byte: copy L + 3 bytes from (oo << 8 | byte) + 1 back, dictionary included
+#define LZ_MIN_MATCH   3
+#define LZ_MAX_MATCH   (LZ_MIN_MATCH + 31)
+#define LZ_MAX_OFFSET  1024
+#define LZ_MAX_LITERAL 128
+
+// hash chains over 3 byte prefixes, static: compression runs on one task only
+#define LZ_HASH_SIZE   512
+#define LZ_HISTORY_MAX 1024     // dictionary plus input
+#define LZ_CHAIN_DEPTH 16
+#define LZ_NONE        0xFFFF
+
+static uint16_t s_lz_head[LZ_HASH_SIZE];
+static uint16_t s_lz_prev[LZ_HISTORY_MAX];
+
+size_t lz_compress(const uint8_t *dict, size_t dict_len, const uint8_t *src, size_t src_len, uint8_t *dest, size_t dest_cap) {
+    if (dict == NULL) dict_len = 0;
+    if (dict_len + src_len > LZ_HISTORY_MAX) return 0;
+
+    // dictionary and input seen as one history buffer
+    const size_t history_len = dict_len + src_len;
+    auto at = [&](size_t i) { return i < dict_len ? dict[i] : src[i - dict_len]; };
+    auto hash = [&](size_t i) { return ((at(i) << 6) ^ (at(i + 1) << 3) ^ at(i + 2)) & (LZ_HASH_SIZE - 1); };
+    auto insert = [&](size_t i) {
+        if (i + LZ_MIN_MATCH > history_len) return;
+        const size_t h = hash(i);
+        s_lz_prev[i] = s_lz_head[h];
+        s_lz_head[h] = i;
+    };
+
+    for (size_t h = 0; h < LZ_HASH_SIZE; h++) s_lz_head[h] = LZ_NONE;
+    for (size_t i = 0; i < dict_len; i++) insert(i);
+
+    size_t write_index = 0;
+    size_t literal_start = 0;
+    size_t literal_len = 0;
+
+    auto flush_literals = [&]() -> bool {
+        if (literal_len == 0) return true;
+        if (write_index + 1 + literal_len > dest_cap) return false;
+        dest[write_index++] = (uint8_t)(literal_len - 1);
+        for (size_t i = 0; i < literal_len; i++) dest[write_index++] = src[literal_start + i];
+        literal_len = 0;
+        return true;
+    };
+
+    size_t i = 0;
+    while (i < src_len) {
+        const size_t pos = dict_len + i;
+        const size_t max_len = src_len - i < LZ_MAX_MATCH ? src_len - i : LZ_MAX_MATCH;
+
+        size_t best_len = 0;
+        size_t best_offset = 0;
+        if (max_len >= LZ_MIN_MATCH) {
+            uint16_t j = s_lz_head[hash(pos)];
+            for (size_t depth = 0; j != LZ_NONE && depth < LZ_CHAIN_DEPTH && best_len < max_len; depth++, j = s_lz_prev[j]) {
+                if (pos - j > LZ_MAX_OFFSET) break;
+
+                size_t len = 0;
+                while (len < max_len && at(j + len) == src[i + len]) len++;
+                if (len > best_len) {
+                    best_len = len;
+                    best_offset = pos - j;
+                }
+            }
+        }
+
+        if (best_len >= LZ_MIN_MATCH) {
+            if (!flush_literals() || write_index + 2 > dest_cap) return 0;
+            const size_t offset = best_offset - 1;
+            dest[write_index++] = 0x80 | ((offset >> 8) & 0x3) << 5 | (best_len - LZ_MIN_MATCH);
+            dest[write_index++] = offset & 0xFF;
+            for (size_t k = 0; k < best_len; k++) insert(pos + k);
+            i += best_len;
+            continue;
+        }
+
+        if (literal_len == 0) literal_start = i;
+        literal_len++;
+        insert(pos);
+        i++;
+        if (literal_len == LZ_MAX_LITERAL && !flush_literals()) return 0;
+    }
+
+    return flush_literals() ? write_index : 0;
+}
+
+size_t lz_decompress(const uint8_t *dict, size_t dict_len, const uint8_t *src, size_t src_len, uint8_t *dest, size_t dest_cap) {
+    if (dict == NULL) dict_len = 0;
+
+    size_t write_index = 0;
+    size_t read_index = 0;
+
+    while (read_index < src_len) {
+        const uint8_t token = src[read_index++];
+
+        if (!(token & 0x80)) {
+            const size_t literal_len = token + 1;
+            if (read_index + literal_len > src_len || write_index + literal_len > dest_cap) return 0;
+            for (size_t i = 0; i < literal_len; i++) dest[write_index++] = src[read_index++];
+            continue;
+        }
+
+        if (read_index >= src_len) return 0;
+        const size_t offset = (((token >> 5) & 0x3) << 8 | src[read_index++]) + 1;
+        const size_t len = (token & 0x1F) + LZ_MIN_MATCH;
+        const size_t pos = dict_len + write_index;
+        if (offset > pos || write_index + len > dest_cap) return 0;
+
+        // byte by byte: a match may overlap what it is writing
+        for (size_t k = 0; k < len; k++) {
+            const size_t from = pos - offset + k;
+            dest[write_index++] = from < dict_len ? dict[from] : dest[from - dict_len];
+        }
+    }
+
+    return write_index;
+}
+
+
+// ------- CODECS --------
+static const uint8_t *s_glyph_dict = nullptr;
+static size_t s_glyph_dict_len = 0;
+
+void set_glyph_dictionary(const uint8_t *dict, size_t len) {
+    s_glyph_dict = dict;
+    s_glyph_dict_len = len;
+}
+
+static size_t rle_encode(const uint8_t *src, size_t src_len, uint8_t *dest, size_t dest_cap) {
+    if (dest_cap < src_len * 2) return 0;
+    size_t len = 0;
+    rle_compress(src, src_len, dest, &len);
+    return len;
+}
+
+static size_t bit_rle_encode(const uint8_t *src, size_t src_len, uint8_t *dest, size_t dest_cap) {
+    size_t len = 0;
+    bit_rle_compress(src, src_len, dest, &len, dest_cap);
+    return len;
+}
+
+static size_t lz_encode(const uint8_t *src, size_t src_len, uint8_t *dest, size_t dest_cap) {
+    return lz_compress(nullptr, 0, src, src_len, dest, dest_cap);
+}
+
+static size_t lz_decode(const uint8_t *src, size_t src_len, uint8_t *dest, size_t dest_cap) {
+    return lz_decompress(nullptr, 0, src, src_len, dest, dest_cap);
+}
+
+static size_t glyph_lz_encode(const uint8_t *src, size_t src_len, uint8_t *dest, size_t dest_cap) {
+    if (!s_glyph_dict) return 0;
+    return lz_compress(s_glyph_dict, s_glyph_dict_len, src, src_len, dest, dest_cap);
+}
+
+static size_t glyph_lz_decode(const uint8_t *src, size_t src_len, uint8_t *dest, size_t dest_cap) {
+    if (!s_glyph_dict) return 0;
+    return lz_decompress(s_glyph_dict, s_glyph_dict_len, src, src_len, dest, dest_cap);
+}
+
+const Codec CODECS[CODEC_COUNT] = {
+    { ScreenCodec::Rle,      "rle",      rle_encode,        rle_decompress      },
+    { ScreenCodec::BitRle,   "bit_rle",  bit_rle_encode,    bit_rle_decompress  },
+    { ScreenCodec::PackBits, "packbits", packbits_compress, packbits_decompress },
+    { ScreenCodec::Lz,       "lz",       lz_encode,         lz_decode           },
+    { ScreenCodec::GlyphLz,  "glyph_lz", glyph_lz_encode,   glyph_lz_decode     },
+};
+
+const Codec *codec_by_id(uint8_t id) {
+    for (size_t i = 0; i < CODEC_COUNT; i++)
+        if (CODECS[i].id == id) return &CODECS[i];
+    return nullptr;
+}
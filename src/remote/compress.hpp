@@ -2,7 +2,16 @@
 #include <cinttypes>
 #include <cstddef>
 
-void bit_rle_compress(const uint8_t *src, const size_t src_len, uint8_t *dest, size_t *dest_len);
+/** dest_len is 0 when the output would not fit in dest_cap */
+void bit_rle_compress(const uint8_t *src, const size_t src_len, uint8_t *dest, size_t *dest_len, const size_t dest_cap);
+size_t bit_rle_decompress(const uint8_t *src, const size_t src_len, uint8_t *dest, const size_t dest_cap);
+
+size_t packbits_compress(const uint8_t *src, const size_t src_len, uint8_t *dest, const size_t dest_cap);
+size_t packbits_decompress(const uint8_t *src, const size_t src_len, uint8_t *dest, const size_t dest_cap);
+
+/** byte lz: literal runs and (length, offset) matches, dict is history in front of src, may be null */
+size_t lz_compress(const uint8_t *dict, const size_t dict_len, const uint8_t *src, const size_t src_len, uint8_t *dest, const size_t dest_cap);
+size_t lz_decompress(const uint8_t *dict, const size_t dict_len, const uint8_t *src, const size_t src_len, uint8_t *dest, const size_t dest_cap);
 
 
 inline void rle_compress(const uint8_t *src, const size_t src_len, uint8_t *dest, size_t *dest_len) {
@@ -33,4 +42,52 @@ inline void rle_compress(const uint8_t *src, const size_t src_len, uint8_t *dest
     }
 
     *dest_len = write_index;
-}
\ No newline at end of file
+}
+
+
+/** inverse of rle_compress, returns the bytes written or 0 when src is malformed or does not fit */
+inline size_t rle_decompress(const uint8_t *src, const size_t src_len, uint8_t *dest, const size_t dest_cap) {
+    if (src == NULL || dest == NULL || src_len % 2 != 0) return 0;
+
+    size_t write_index = 0;
+
+    for (size_t read_index = 0; read_index < src_len; read_index += 2) {
+        const uint8_t value = src[read_index];
+        const size_t run_length = src[read_index + 1];
+        if (run_length == 0 || write_index + run_length > dest_cap) return 0;
+
+        for (size_t i = 0; i < run_length; i++) dest[write_index++] = value;
+    }
+
+    return write_index;
+}
+
+
+// ------- CODECS --------
+namespace ScreenCodec {
+    enum Value {
+        Rle      = 0x01,
+        BitRle   = 0x02,
+        PackBits = 0x03,
+        Lz       = 0x04,
+        GlyphLz  = 0x05,    // lz over a dictionary of the ui font glyphs, see set_glyph_dictionary
+    };
+};
+
+/** both return 0 on failure: output does not fit for encode, malformed input for decode */
+using CodecFn = size_t(*)(const uint8_t *src, size_t src_len, uint8_t *dest, size_t dest_cap);
+
+struct Codec {
+    uint8_t     id;     // ScreenCodec, goes on the wire
+    const char *name;
+    CodecFn     encode;
+    CodecFn     decode;
+};
+
+constexpr size_t CODEC_COUNT = 5;
+extern const Codec CODECS[CODEC_COUNT];
+
+const Codec *codec_by_id(uint8_t id);
+
+/** GlyphLz is unusable until the dictionary is set, both ends must hold the same bytes */
+void set_glyph_dictionary(const uint8_t *dict, size_t len);
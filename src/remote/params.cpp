@@ -0,0 +1,91 @@
+#include "params.hpp"
+#include <cstring>
+#include "storage/patches.hpp"
+
+#define PARAM_HEADER_SIZE 2     // op, count
+
+/** packs values into as few packets as the reply capacity allows */
+static void send_values(uint8_t op, const ParamValue *values, size_t count, const ParamReply &reply) {
+    static uint8_t packet[PARAM_REQUEST_MAX];
+    const size_t capacity = reply.capacity < sizeof(packet) ? reply.capacity : sizeof(packet);
+    const size_t per_packet = constrain((capacity - PARAM_HEADER_SIZE) / sizeof(ParamValue), (size_t)1, (size_t)255);
+
+    do {
+        const size_t n = count < per_packet ? count : per_packet;
+        packet[0] = op;
+        packet[1] = n;
+        memcpy(packet + PARAM_HEADER_SIZE, values, n * sizeof(ParamValue));
+        reply.send(packet, PARAM_HEADER_SIZE + n * sizeof(ParamValue));
+
+        values += n;
+        count -= n;
+    } while(count > 0);
+}
+
+static void send_error(uint8_t request_op, const ParamReply &reply) {
+    const uint8_t packet[] = { ParamOp::Error, request_op };
+    reply.send(packet, sizeof(packet));
+}
+
+
+void params::handle(UiController &controller, const ParamRequest &request, const ParamReply &reply) {
+    static ParamValue values[PARAM_COUNT];
+    if(request.len == 0) return;
+
+    const uint8_t op = request.data[0];
+    const uint8_t count = request.len >= PARAM_HEADER_SIZE ? request.data[1] : 0;
+    const uint8_t *body = request.data + PARAM_HEADER_SIZE;
+    size_t found = 0;
+
+    switch(op) {
+        case ParamOp::Get: {
+            if(request.len < PARAM_HEADER_SIZE + count * sizeof(uint16_t)) return send_error(op, reply);
+
+            for(size_t i = 0; i < count && found < PARAM_COUNT; i++) {
+                uint16_t id;
+                int32_t raw;
+                memcpy(&id, body + i * sizeof(id), sizeof(id));
+                if(controller.get_param(id, &raw)) values[found++] = { id, raw };
+            }
+            return send_values(ParamOp::Values, values, found, reply);
+        }
+        case ParamOp::Set: {
+            if(request.len < PARAM_HEADER_SIZE + count * sizeof(ParamValue)) return send_error(op, reply);
+
+            for(size_t i = 0; i < count && found < PARAM_COUNT; i++) {
+                ParamValue value;
+                memcpy(&value, body + i * sizeof(value), sizeof(value));
+                int32_t raw;
+                if(!controller.set_param(value.id, value.raw) || !controller.get_param(value.id, &raw)) continue;
+                values[found++] = { value.id, raw };
+            }
+            return send_values(ParamOp::Values, values, found, reply);
+        }
+        case ParamOp::Dump: {
+            found = controller.dump_params(values, PARAM_COUNT);
+            return send_values(ParamOp::Values, values, found, reply);
+        }
+        case ParamOp::Load: {
+            if(request.len < 2 || !patches::load(controller, request.data[1])) return send_error(op, reply);
+
+            found = controller.dump_params(values, PARAM_COUNT);
+            return send_values(ParamOp::Values, values, found, reply);
+        }
+        case ParamOp::Save: {
+            if(request.len < 2 || !patches::save(controller, request.data[1])) return send_error(op, reply);
+
+            const uint8_t packet[] = { ParamOp::Saved, request.data[1] };
+            return reply.send(packet, sizeof(packet));
+        }
+        default:
+            return send_error(op, reply);
+    }
+}
+
+
+void params::notify_changes(UiController &controller, const ParamReply &reply) {
+    static ParamValue values[PARAM_COUNT];
+
+    const size_t count = controller.changed_params(values, PARAM_COUNT);
+    if(count) send_values(ParamOp::Changed, values, count, reply);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cinttypes>
+#include <cstddef>
+#include "config.h"
+#include "ui/UiController.hpp"
+
+/**
+ * parameter protocol, little endian, ids and raw values as in UiController:
+ *  Get:  op, count, id[count]          -> Values
+ *  Set:  op, count, {id, raw}[count]   -> Values with the applied (clamped) values
+ *  Dump: op                            -> Values, every parameter, as many packets as needed
+ *  Load: op, slot                      -> Values, every parameter of the recalled patch
+ *  Save: op, slot                      -> Saved, slot
+ *  Changed is sent unrequested when a value changes, encoder turns included.
+ * a patch load is a Set with every pair, ~50 pairs fit one packet at the max mtu.
+ */
+namespace ParamOp {
+    enum Value {
+        Get     = 0x01,
+        Set     = 0x02,
+        Dump    = 0x03,
+        Load    = 0x04,
+        Save    = 0x05,
+        Values  = 0x80,     // op, count, {id, raw}[count]
+        Changed = 0x81,     // same layout as Values
+        Saved   = 0x82,     // op, slot
+        Error   = 0xFF,     // op, request op
+    };
+};
+
+namespace ParamSource {
+    enum Value {
+        Ble,
+        Serial,
+    };
+};
+
+struct ParamRequest {
+    uint8_t  source;    // ParamSource, where replies go
+    uint16_t len;
+    uint8_t  data[PARAM_REQUEST_MAX];
+};
+
+/** sends one reply packet, capacity is the largest packet it accepts */
+struct ParamReply {
+    void (*send)(const uint8_t *data, size_t len);
+    size_t capacity;
+};
+
+namespace params {
+    /** runs on the ui task, the only owner of the widgets */
+    void handle(UiController &controller, const ParamRequest &request, const ParamReply &reply);
+    void notify_changes(UiController &controller, const ParamReply &reply);
+};
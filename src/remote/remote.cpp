@@ -1,22 +1,64 @@
 #include "remote.hpp"
 #include <NimBLEDevice.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
 
 #include "perf.h"
 #include "config.h"
 #include "uuids.h"
 #include "compress.hpp"
+#include "params.hpp"
+#include "screen_stream.hpp"
 
-#define SCREEN_BLOCK_NUM  4
-#define SCREEN_BLOCK_SIZE (128*2)
+#define SCREEN_BLOCK_NUM   4
+#define SCREEN_BLOCK_PAGES 2
+#define SCREEN_BLOCK_SIZE  (128 * SCREEN_BLOCK_PAGES)
+#define SCREEN_KEYFRAME_INTERVAL 32    // messages per block, bounds how long a lost patch shows
 
-static NimBLEServer* s_server;
-static InputEventCallback s_input_callback = nullptr;
+// codecs the encoder picks the smallest from, see SCREEN_CODEC_BENCH to compare them on real frames.
+// GlyphLz stays out until it is measured on frames drawn with the device font
+#define SCREEN_STREAM_CODECS (SCREEN_CODEC_BIT(ScreenCodec::Rle) | SCREEN_CODEC_BIT(ScreenCodec::PackBits))
 
-NimBLECharacteristic* s_block_chars[4] = {
-    nullptr, nullptr, nullptr, nullptr
-};
+// the glyph dictionary is longer than an attribute value may be, each read returns the next chunk
+#define GLYPH_CHUNK_SIZE 256
 
-static uint8_t s_screen_buffer[SCREEN_BUFFER_SIZE] = {0};
+static NimBLEServer* s_server;
+static InputEventCallback s_input_callback = nullptr;
+static ParamWriteCallback s_param_callback = nullptr;
+static MidiPacketCallback s_midi_callback = nullptr;
+
+static NimBLECharacteristic* s_screen_char = nullptr;
+static NimBLECharacteristic* s_stats_char = nullptr;
+static NimBLECharacteristic* s_glyphs_char = nullptr;
+static NimBLECharacteristic* s_params_char = nullptr;
+
+static ScreenEncoder<SCREEN_BLOCK_SIZE> s_block_encoders[SCREEN_BLOCK_NUM];
+static volatile bool s_keyframe_requested = false;   // set from the ble host task
+
+// latest frame wins: a submit overwrites the frame the screen task has not taken yet
+static SemaphoreHandle_t s_mailbox_mutex = nullptr;
+static TaskHandle_t s_screen_task = nullptr;
+static uint8_t s_mailbox[SCREEN_BUFFER_SIZE];
+static uint8_t s_mailbox_pages = 0;
+static uint32_t s_dropped_frames = 0;
+static uint8_t s_sending[SCREEN_BUFFER_SIZE];       // owned by the screen task
+
+// link state, written from the ble host task
+static volatile uint16_t s_mtu = 23;
+static volatile bool s_connected = false;
+
+// aimd on the stream interval: a notify the stack could not queue backs off, clean rounds speed up
+#define SCREEN_RATE_STEP_MS 2
+static uint32_t s_interval_ms = SCREEN_MIN_INTERVAL_MS;
+static bool s_notify_failed = false;
+static uint32_t s_bytes_sent = 0;
+
+static void request_keyframe() {
+    s_keyframe_requested = true;
+    if(s_screen_task) xTaskNotifyGive(s_screen_task);
+}
 
 static const char *BLE_REMOTE_TAG = "BLE_REMOTE";
 
@@ -25,14 +67,25 @@ class ServerCallbacks : public NimBLEServerCallbacks {
     void onConnect(NimBLEServer* pServer, NimBLEConnInfo& connInfo) override {
         ESP_LOGD(BLE_REMOTE_TAG, "Client address: %s\n", connInfo.getAddress().toString().c_str());
         // SET: min connection interval, max connection interval, latency, supervision timeout.
-        pServer->updateConnParams(connInfo.getConnHandle(), 24, 48, 0, 180);
+        pServer->updateConnParams(connInfo.getConnHandle(), BLE_CONN_INTERVAL_MIN, BLE_CONN_INTERVAL_MAX, 0, 180);
+        pServer->setDataLen(connInfo.getConnHandle(), BLE_MAX_TX_OCTETS);
+        s_mtu = connInfo.getMTU();
+        s_connected = true;
+        request_keyframe();
     }
 
     void onDisconnect(NimBLEServer* pServer, NimBLEConnInfo& connInfo, int reason) override {
         ESP_LOGD(BLE_REMOTE_TAG, "Client disconnected - start advertising\n");
+        s_connected = false;
+        s_mtu = 23;
         NimBLEDevice::startAdvertising();
     }
 
+    void onMTUChange(uint16_t mtu, NimBLEConnInfo& connInfo) override {
+        ESP_LOGD(BLE_REMOTE_TAG, "MTU: %d\n", mtu);
+        s_mtu = mtu;
+    }
+
 } server_callbacks;
 
 
@@ -43,18 +96,53 @@ namespace RemoteEvents {
     };
 };
 
+struct __attribute__((packed)) InputCommand {
+    uint8_t type;
+    uint8_t id;
+    int8_t  value;
+    uint8_t shifted;
+};
+
+// ------- IN PLACE READS --------
+#define ATT_VALUE_MAX 512   // BLE_ATT_ATTR_MAX_LEN, the longest value a write carries
+
+/** grows the value storage to ATT_VALUE_MAX and leaves it empty, the storage never shrinks afterwards */
+static void reserve_value(NimBLECharacteristic *blechar) {
+    static const uint8_t zeros[ATT_VALUE_MAX] = {0};
+    blechar->setValue(zeros, sizeof(zeros));
+    blechar->setValue(zeros, 0);
+}
+
+template<size_t N>
+struct AttValue { uint8_t data[N]; };
+
+/**
+ * copies the last write into out without the heap copy getValue() makes. the typed getValue
+ * reads all of N unchecked, reserve_value makes sure the storage holds that much
+ */
+template<size_t N>
+static size_t read_value(NimBLECharacteristic *blechar, uint8_t (&out)[N]) {
+    static_assert(N <= ATT_VALUE_MAX, "larger than the reserved value");
+
+    const size_t len = blechar->getLength();
+    memcpy(out, blechar->getValue<AttValue<N>>(nullptr, true).data, N);
+    return len < N ? len : N;
+}
+
+
 class CommandCbs : public NimBLECharacteristicCallbacks {
     void onWrite(NimBLECharacteristic* blechar, NimBLEConnInfo& conn_info) override {        
-        auto value = blechar->getValue();
-        const uint8_t *data = value.data();
-        size_t len = value.length();
-        
+        // read in place: getValue() without a type returns an owning (heap) copy
+        if(blechar->getLength() != sizeof(InputCommand)) return;
+        const auto command = blechar->getValue<InputCommand>();
+
         // input command
-        if(len == 4 && data[0] == RemoteEvents::Input) {
+        if(command.type == RemoteEvents::Input) {
             InputEvent event;
-            event.id = input_id_from_uint8(data[1]);
-            event.value = (int8_t)data[2];
-            event.shifed = data[3] > 0;
+            event.id = input_id_from_uint8(command.id);
+            event.value = command.value;
+            event.shifed = command.shifted > 0;
+            event.timestamp_us = (uint32_t)esp_timer_get_time();
 
             ESP_LOGD(BLE_REMOTE_TAG, "id: %d, val: %d, shift: %d\n", event.id, event.value, event.shifed);
             if(s_input_callback) s_input_callback(event);
@@ -63,28 +151,99 @@ class CommandCbs : public NimBLECharacteristicCallbacks {
 } command_blechar_cb;
 
 
-static void align_screen_blocks(bool notify = false) {
-    static uint8_t rle_data[SCREEN_BUFFER_SIZE * 2];
-    
-    for(size_t i = 0; i < SCREEN_BLOCK_NUM; i++) {
-        auto c = s_block_chars[i];
-        
-        // START_PERF(read_bt)
-        size_t write_offset = i * SCREEN_BLOCK_SIZE;
-        uint8_t *data = s_screen_buffer + write_offset;
-        size_t data_len = SCREEN_BLOCK_SIZE;
-        
-        size_t rle_len = 0;
-        rle_compress(data, data_len, rle_data, &rle_len);
-
-        c->setValue(rle_data, rle_len);
-        if(notify) c->notify();
+class ParamsCbs : public NimBLECharacteristicCallbacks {
+    void onWrite(NimBLECharacteristic* blechar, NimBLEConnInfo& conn_info) override {
+        static ParamRequest request;   // only the ble host task writes here
+        request.source = ParamSource::Ble;
+        request.len = read_value(blechar, request.data);
+        if(s_param_callback) s_param_callback(request);
     }
+} params_blechar_cb;
+
+
+class MidiCbs : public NimBLECharacteristicCallbacks {
+    void onWrite(NimBLECharacteristic* blechar, NimBLEConnInfo& conn_info) override {
+        static uint8_t packet[ATT_VALUE_MAX];   // only the ble host task writes here
+        const uint32_t arrival_us = esp_timer_get_time();
+        const size_t len = read_value(blechar, packet);
+        if(s_midi_callback) s_midi_callback(packet, len, arrival_us);
+    }
+} midi_blechar_cb;
+
+
+struct __attribute__((packed)) GlyphChunkHeader {
+    uint8_t index;
+    uint8_t count;
+};
+
+static const uint8_t *s_glyph_dict = nullptr;
+static size_t s_glyph_len = 0;
+static uint8_t s_glyph_chunk = 0;   // served by the next read
+
+class GlyphsCbs : public NimBLECharacteristicCallbacks {
+    // header then up to GLYPH_CHUNK_SIZE bytes at index * GLYPH_CHUNK_SIZE, the client reads until it has every index
+    void onRead(NimBLECharacteristic* blechar, NimBLEConnInfo& conn_info) override {
+        static uint8_t chunk[sizeof(GlyphChunkHeader) + GLYPH_CHUNK_SIZE];
+        static_assert(sizeof(chunk) <= ATT_VALUE_MAX, "glyph chunk larger than an attribute value");
+        if(!s_glyph_dict) return;
+
+        const uint8_t count = (s_glyph_len + GLYPH_CHUNK_SIZE - 1) / GLYPH_CHUNK_SIZE;
+        const GlyphChunkHeader header = { s_glyph_chunk, count };
+        const size_t offset = s_glyph_chunk * GLYPH_CHUNK_SIZE;
+        const size_t len = s_glyph_len - offset < GLYPH_CHUNK_SIZE ? s_glyph_len - offset : GLYPH_CHUNK_SIZE;
+
+        memcpy(chunk, &header, sizeof(header));
+        memcpy(chunk + sizeof(header), s_glyph_dict + offset, len);
+        blechar->setValue(chunk, sizeof(header) + len);
+        if(blechar->getLength() != sizeof(header) + len)
+            ESP_LOGE(BLE_REMOTE_TAG, "glyph chunk %d not taken", s_glyph_chunk);
+
+        s_glyph_chunk = (s_glyph_chunk + 1) % count;
+    }
+} glyphs_blechar_cb;
+
+
+class ScreenCbs : public NimBLECharacteristicCallbacks {
+    // a new subscriber holds nothing a patch could apply to
+    void onSubscribe(NimBLECharacteristic* blechar, NimBLEConnInfo& conn_info, uint16_t sub_value) override {
+        if(sub_value) request_keyframe();
+    }
+} screen_blechar_cb;
+
+
+// ------- SCREEN PACKING --------
+#define ATT_NOTIFY_OVERHEAD 3   // opcode and handle
+
+static ScreenPacker<BLE_MAX_MTU> s_packer;
+
+static void send_packet(const uint8_t *packet, size_t len) {
+    if(!s_screen_char->notify(packet, len)) s_notify_failed = true;
+    s_bytes_sent += len;
+}
+
+static void flush_packet() {
+    s_packer.flush(send_packet);
+}
+
+/** appends a message as segments, as few notifications as the mtu allows */
+static void pack_message(uint8_t block, const uint8_t *message, size_t len) {
+    const size_t capacity = constrain((size_t)s_mtu - ATT_NOTIFY_OVERHEAD, (size_t)20, sizeof(s_packer.packet));
+    s_packer.pack(block, message, len, capacity, send_packet);
+}
+
+/** keyframe or xor patch against what was sent last, see screen_stream.hpp */
+static void align_screen_block(size_t i, const uint8_t *data) {
+    static uint8_t message[SCREEN_STREAM_MAX_LEN(SCREEN_BLOCK_SIZE)];
+
+    const size_t len = s_block_encoders[i].encode(data, message, SCREEN_KEYFRAME_INTERVAL, SCREEN_STREAM_CODECS);
+    pack_message(i, message, len);
 }
 
 
 void remote::init() {
+    s_mailbox_mutex = xSemaphoreCreateMutex();
     NimBLEDevice::init(BLE_NAME);
+    NimBLEDevice::setMTU(BLE_MAX_MTU);
 
     s_server = NimBLEDevice::createServer();
     s_server->setCallbacks(&server_callbacks);
@@ -95,16 +254,30 @@ void remote::init() {
     command_blechar->setValue("");
     command_blechar->setCallbacks(&command_blechar_cb);
 
-    for(size_t i = 0; i < SCREEN_BLOCK_NUM; i++) {
-        s_block_chars[i] = service->createCharacteristic(UUID_BLOCK[i], NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY);
-    }
-    align_screen_blocks(false);
+    s_stats_char = service->createCharacteristic(STATS_BLECHAR_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY);
+    s_glyphs_char = service->createCharacteristic(GLYPHS_BLECHAR_UUID, NIMBLE_PROPERTY::READ);
+    s_glyphs_char->setCallbacks(&glyphs_blechar_cb);
+
+    s_params_char = service->createCharacteristic(PARAMS_BLECHAR_UUID, NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_NR | NIMBLE_PROPERTY::NOTIFY, BLE_MAX_MTU);
+    reserve_value(s_params_char);
+    s_params_char->setCallbacks(&params_blechar_cb);
+
+    s_screen_char = service->createCharacteristic(SCREEN_BLECHAR_UUID, NIMBLE_PROPERTY::NOTIFY);
+    s_screen_char->setCallbacks(&screen_blechar_cb);
 
     service->start();
 
+    // the spec asks for read (empty), write without response and notify
+    NimBLEService* midi_service = s_server->createService(MIDI_SERVICE_UUID);
+    auto midi_blechar = midi_service->createCharacteristic(MIDI_BLECHAR_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE_NR | NIMBLE_PROPERTY::NOTIFY);
+    reserve_value(midi_blechar);
+    midi_blechar->setCallbacks(&midi_blechar_cb);
+    midi_service->start();
+
     auto advertising = NimBLEDevice::getAdvertising();
     advertising->setName(BLE_NAME);
     advertising->addServiceUUID(SERVER_UUID);
+    advertising->addServiceUUID(MIDI_SERVICE_UUID);
     advertising->enableScanResponse(true);
 
     advertising->start();
@@ -116,17 +289,147 @@ void remote::set_input_cb(InputEventCallback cb) {
 }
 
 
+void remote::set_param_cb(ParamWriteCallback cb) {
+    s_param_callback = cb;
+}
+
+void remote::set_midi_cb(MidiPacketCallback cb) {
+    s_midi_callback = cb;
+}
+
+void remote::send_params(const uint8_t *data, size_t len) {
+    if(!s_params_char || !s_connected) return;
+    s_params_char->notify(data, len);
+}
+
+size_t remote::notify_capacity() {
+    return s_mtu - ATT_NOTIFY_OVERHEAD;
+}
+
+
 /**
  * rle on paged data -> x0.65
  * rle on colmaj data -> x0.93 -> nope
+ * the other codecs: build with -DSCREEN_CODEC_BENCH
  */
 
-void remote::send_screen(const uint8_t *data) {
-    bool is_same = memcmp(data, s_screen_buffer, SCREEN_BUFFER_SIZE) == 0;
-    if(!is_same) {
-        memcpy(s_screen_buffer, data, SCREEN_BUFFER_SIZE);
-        align_screen_blocks(true);
-    }        
+#ifdef SCREEN_CODEC_BENCH
+#define SCREEN_CODEC_BENCH_BLOCKS 200
+
+/** every codec on the same blocks the stream sends, as keyframe (the block) and as patch (xor with the previous one) */
+static void bench_screen_block(size_t i, const uint8_t *data) {
+    static uint8_t previous[SCREEN_BLOCK_NUM][SCREEN_BLOCK_SIZE];
+    static uint8_t patch[SCREEN_BLOCK_SIZE];
+    static uint8_t out[SCREEN_BLOCK_SIZE * 2];
+    static uint32_t bytes[CODEC_COUNT][2];
+    static uint32_t time_us[CODEC_COUNT][2];
+    static uint32_t blocks = 0;
+
+    for(size_t k = 0; k < SCREEN_BLOCK_SIZE; k++) patch[k] = data[k] ^ previous[i][k];
+    memcpy(previous[i], data, SCREEN_BLOCK_SIZE);
+
+    for(size_t c = 0; c < CODEC_COUNT; c++) {
+        const uint8_t *inputs[2] = { data, patch };
+        for(size_t m = 0; m < 2; m++) {
+            const int64_t start = esp_timer_get_time();
+            const size_t len = CODECS[c].encode(inputs[m], SCREEN_BLOCK_SIZE, out, sizeof(out));
+            time_us[c][m] += esp_timer_get_time() - start;
+            bytes[c][m] += len ? len : SCREEN_BLOCK_SIZE * 2;   // a failed encode costs the rle worst case
+        }
+    }
+
+    if(++blocks % SCREEN_CODEC_BENCH_BLOCKS) return;
+
+    ESP_LOGI(BLE_REMOTE_TAG, "codec bench, %d blocks of %d bytes", blocks, SCREEN_BLOCK_SIZE);
+    for(size_t c = 0; c < CODEC_COUNT; c++) {
+        ESP_LOGI(BLE_REMOTE_TAG, "[%s]> key x%.3f %dus, patch x%.3f %dus", CODECS[c].name,
+            (float)bytes[c][0] / (blocks * SCREEN_BLOCK_SIZE), time_us[c][0] / blocks,
+            (float)bytes[c][1] / (blocks * SCREEN_BLOCK_SIZE), time_us[c][1] / blocks);
+    }
+}
+#endif
+
+/** data is the published frame (FrameManager front), pages the diff against the previous one */
+void remote::send_screen(const uint8_t *data, uint8_t pages) {
+    if(pages == 0 || !s_mailbox_mutex) return;
+
+    xSemaphoreTake(s_mailbox_mutex, portMAX_DELAY);
+    if(s_mailbox_pages) s_dropped_frames++;
+    memcpy(s_mailbox, data, SCREEN_BUFFER_SIZE);
+    s_mailbox_pages |= pages;   // a dropped frame's pages still differ from what was sent
+    xSemaphoreGive(s_mailbox_mutex);
+
+    if(s_screen_task) xTaskNotifyGive(s_screen_task);
+}
+
+
+void remote::screen_task(void *arg) {
+    const uint8_t block_mask = (1 << SCREEN_BLOCK_PAGES) - 1;
+    s_screen_task = xTaskGetCurrentTaskHandle();
+
+    while(true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        xSemaphoreTake(s_mailbox_mutex, portMAX_DELAY);
+        uint8_t pages = s_mailbox_pages;
+        if(pages) memcpy(s_sending, s_mailbox, SCREEN_BUFFER_SIZE);
+        s_mailbox_pages = 0;
+        xSemaphoreGive(s_mailbox_mutex);
+
+        // s_sending always holds the latest frame taken, enough for a keyframe
+        if(s_keyframe_requested) {
+            s_keyframe_requested = false;
+            for(auto &encoder : s_block_encoders) encoder.force_keyframe = true;
+            pages = 0xFF;
+        }
+
+        if(!s_connected || pages == 0) continue;
+
+        for(size_t i = 0; i < SCREEN_BLOCK_NUM; i++) {
+            if(!(pages & (block_mask << (i * SCREEN_BLOCK_PAGES)))) continue;
+#ifdef SCREEN_CODEC_BENCH
+            bench_screen_block(i, s_sending + i * SCREEN_BLOCK_SIZE);
+#endif
+            align_screen_block(i, s_sending + i * SCREEN_BLOCK_SIZE);
+        }
+        flush_packet();
+
+        // a failed notify left the client with a broken message, resync with keyframes
+        if(s_notify_failed) {
+            s_notify_failed = false;
+            s_interval_ms = constrain(s_interval_ms * 2, (uint32_t)SCREEN_MIN_INTERVAL_MS, (uint32_t)SCREEN_MAX_INTERVAL_MS);
+            request_keyframe();
+        }
+        else if(s_interval_ms > SCREEN_MIN_INTERVAL_MS + SCREEN_RATE_STEP_MS) s_interval_ms -= SCREEN_RATE_STEP_MS;
+        else s_interval_ms = SCREEN_MIN_INTERVAL_MS;
+
+        // frames submitted while waiting collapse in the mailbox, input writes get the air time
+        vTaskDelay(pdMS_TO_TICKS(s_interval_ms));
+    }
+}
+
+
+remote::StreamStats remote::stream_stats() {
+    return { s_dropped_frames, s_bytes_sent, s_interval_ms, s_mtu };
+}
+
+
+void remote::set_glyph_dictionary(const uint8_t *dict, size_t len) {
+    ::set_glyph_dictionary(dict, len);
+
+    // served in chunks on read, the count has to fit the chunk header
+    s_glyph_dict = len > 0 && len <= 255 * GLYPH_CHUNK_SIZE ? dict : nullptr;
+    s_glyph_len = len;
+    s_glyph_chunk = 0;
+}
+
+
+
+/** monitor::Report, see diag/monitor.hpp */
+void remote::send_stats(const uint8_t *data, size_t len) {
+    if(!s_stats_char) return;
+    s_stats_char->setValue(data, len);
+    s_stats_char->notify();
 }
 
 
@@ -1,12 +1,42 @@
 #pragma once
+#include <cstddef>
 #include "input/events.hpp"
 
 
 using InputEventCallback = void(*)(const InputEvent &);
+struct ParamRequest;
+
+using ParamWriteCallback = void(*)(const ParamRequest &request);
+using MidiPacketCallback = void(*)(const uint8_t *data, size_t len, uint32_t arrival_us);
 
 namespace remote {
     void init();
     void set_input_cb(InputEventCallback cb);
-    void send_screen(const uint8_t *data);
+    /** parameter requests as written, see remote/params.hpp. called from the ble host task */
+    void set_param_cb(ParamWriteCallback cb);
+    /** raw ble-midi packets with their esp_timer arrival time. called from the ble host task */
+    void set_midi_cb(MidiPacketCallback cb);
+    /** notifies a parameter reply, dropped without a client */
+    void send_params(const uint8_t *data, size_t len);
+    /** largest notification the link takes */
+    size_t notify_capacity();
+    /** copies the frame for screen_task and returns, pages: mask of the 8 pixel pages that changed */
+    void send_screen(const uint8_t *data, uint8_t pages);
+    /** compresses and notifies the changed blocks, frames submitted meanwhile collapse into the latest */
+    void screen_task(void *arg);
+
+    struct StreamStats {
+        uint32_t dropped_frames;    // replaced in the mailbox before being sent
+        uint32_t bytes_sent;
+        uint32_t interval_ms;       // current adaptive stream interval
+        uint16_t mtu;
+    };
+    StreamStats stream_stats();
+    void send_stats(const uint8_t *data, size_t len);
+    /**
+     * glyph pages the GlyphLz codec references, also readable by the client: every read of the glyphs
+     * characteristic returns the next chunk as {index, count} then the bytes. dict must outlive the stream
+     */
+    void set_glyph_dictionary(const uint8_t *dict, size_t len);
 };
 
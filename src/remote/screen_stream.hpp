@@ -0,0 +1,291 @@
+#pragma once
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+#include "compress.hpp"
+
+/**
+ * screen block stream: every notify is a header followed by a compressed payload, either
+ *  - keyframe: the block itself
+ *  - patch:    the block xor the previous message, applies only on top of seq - 1
+ * a lost message makes the decoder drop patches until the next keyframe.
+ * messages of all blocks are packed into notifications as segments, a message larger
+ * than the room left is split over consecutive segments of the same block. notifications
+ * are numbered so a lost one is noticed even when it only held the middle of a message.
+ * no arduino dependencies, the decoders are the reference for the remote client.
+ */
+
+namespace ScreenMsg {
+    enum Value {
+        Keyframe = 0x01,
+        Patch    = 0x02,
+    };
+};
+
+struct __attribute__((packed)) ScreenHeader {
+    uint8_t type;   // ScreenMsg
+    uint8_t seq;    // per block, +1 every message, wraps
+    uint8_t codec;  // ScreenCodec of the payload
+};
+
+/** worst case message for a block of n bytes, byte rle always fits */
+#define SCREEN_STREAM_MAX_LEN(n) (sizeof(ScreenHeader) + 2 * (n))
+
+#define SCREEN_CODEC_BIT(id) (1u << (id))
+
+/** in front of every notification, +1 each one, wraps */
+struct __attribute__((packed)) ScreenPacketHeader {
+    uint8_t seq;
+};
+
+struct __attribute__((packed)) ScreenSegment {
+    uint8_t  block;  // block index, with SCREEN_SEGMENT_FIRST / SCREEN_SEGMENT_LAST on the ends of a message
+    uint16_t len;    // bytes of message that follow, little endian
+};
+
+#define SCREEN_SEGMENT_LAST  0x80
+#define SCREEN_SEGMENT_FIRST 0x40
+#define SCREEN_SEGMENT_FLAGS (SCREEN_SEGMENT_LAST | SCREEN_SEGMENT_FIRST)
+
+
+/**
+ * packs messages as segments into notifications of at most capacity bytes (N at most),
+ * send(packet, len) gets every notification that is full or flushed
+ */
+template<size_t N>
+struct ScreenPacker {
+    uint8_t packet[N];
+    size_t len = 0;
+    uint8_t seq = 0;
+
+    template<typename Send>
+    void flush(Send send) {
+        if(len == 0) return;
+        send((const uint8_t*) packet, len);
+        len = 0;
+    }
+
+    template<typename Send>
+    void pack(uint8_t block, const uint8_t *msg, size_t msg_len, size_t capacity, Send send) {
+        if(capacity > N) capacity = N;
+        uint8_t flags = SCREEN_SEGMENT_FIRST;
+
+        while(msg_len > 0) {
+            if(len + sizeof(ScreenSegment) >= capacity) flush(send);
+
+            // a lost notification is a gap in seq on the client
+            if(len == 0) {
+                const ScreenPacketHeader header = { seq++ };
+                memcpy(packet, &header, sizeof(header));
+                len = sizeof(header);
+            }
+
+            const size_t room = capacity - len - sizeof(ScreenSegment);
+            const size_t n = msg_len < room ? msg_len : room;
+            if(n == msg_len) flags |= SCREEN_SEGMENT_LAST;
+            const ScreenSegment segment = { (uint8_t)(block | flags), (uint16_t)n };
+            flags = 0;
+
+            memcpy(packet + len, &segment, sizeof(segment));
+            memcpy(packet + len + sizeof(segment), msg, n);
+            len += sizeof(segment) + n;
+            msg += n;
+            msg_len -= n;
+        }
+    }
+};
+
+
+template<size_t N>
+struct ScreenEncoder {
+    uint8_t sent[N] = {0};  // what the client holds after the last message
+    uint8_t seq = 0;
+    uint16_t since_keyframe = 0;
+    bool force_keyframe = true;
+
+    /**
+     * writes the next message for block into out (SCREEN_STREAM_MAX_LEN(N) bytes), returns its length.
+     * every codec in codec_mask (SCREEN_CODEC_BIT) is tried and the smallest output wins, rle is always tried.
+     */
+    size_t encode(const uint8_t *block, uint8_t *out, uint16_t keyframe_interval, uint32_t codec_mask) {
+        ScreenHeader *header = (ScreenHeader*) out;
+        uint8_t *payload = out + sizeof(ScreenHeader);
+        codec_mask |= SCREEN_CODEC_BIT(ScreenCodec::Rle);
+
+        uint8_t codec = 0;
+        size_t len = compress_best(block, payload, codec_mask, &codec);
+        bool keyframe = force_keyframe || ++since_keyframe >= keyframe_interval;
+
+        // a patch only goes out when it beats the keyframe
+        if(!keyframe) {
+            for(size_t i = 0; i < N; i++) xor_buffer[i] = block[i] ^ sent[i];
+
+            uint8_t patch_codec = 0;
+            const size_t patch_len = compress_best(xor_buffer, patch_buffer, codec_mask, &patch_codec);
+
+            if(patch_len < len) {
+                memcpy(payload, patch_buffer, patch_len);
+                len = patch_len;
+                codec = patch_codec;
+            }
+            else keyframe = true;
+        }
+
+        if(keyframe) {
+            force_keyframe = false;
+            since_keyframe = 0;
+        }
+
+        header->type = keyframe ? ScreenMsg::Keyframe : ScreenMsg::Patch;
+        header->seq = seq++;
+        header->codec = codec;
+        memcpy(sent, block, N);
+
+        return sizeof(ScreenHeader) + len;
+    }
+
+private:
+    // shared by every encoder of the same size, encoding happens on one task
+    static uint8_t xor_buffer[N];
+    static uint8_t patch_buffer[2 * N];
+    static uint8_t scratch[2 * N];
+
+    static size_t compress_best(const uint8_t *src, uint8_t *dest, uint32_t codec_mask, uint8_t *codec) {
+        size_t best = 0;
+
+        for(size_t i = 0; i < CODEC_COUNT; i++) {
+            if(!(codec_mask & SCREEN_CODEC_BIT(CODECS[i].id))) continue;
+
+            const size_t len = CODECS[i].encode(src, N, scratch, sizeof(scratch));
+            if(len == 0 || (best != 0 && len >= best)) continue;
+
+            memcpy(dest, scratch, len);
+            best = len;
+            *codec = CODECS[i].id;
+        }
+
+        return best;
+    }
+};
+
+template<size_t N> uint8_t ScreenEncoder<N>::xor_buffer[N];
+template<size_t N> uint8_t ScreenEncoder<N>::patch_buffer[2 * N];
+template<size_t N> uint8_t ScreenEncoder<N>::scratch[2 * N];
+
+
+template<size_t N>
+struct ScreenDecoder {
+    uint8_t block[N] = {0};
+    uint8_t seq = 0;
+    bool synced = false;    // false until a keyframe arrives, and again after a gap
+
+    /** applies one message, false when it was dropped */
+    bool decode(const uint8_t *msg, size_t len) {
+        if(len < sizeof(ScreenHeader)) return false;
+
+        const ScreenHeader *header = (const ScreenHeader*) msg;
+        const uint8_t *payload = msg + sizeof(ScreenHeader);
+        const size_t payload_len = len - sizeof(ScreenHeader);
+
+        const Codec *codec = codec_by_id(header->codec);
+        if(!codec) return false;
+
+        if(header->type == ScreenMsg::Patch && (!synced || header->seq != (uint8_t)(seq + 1))) {
+            synced = false;
+            return false;
+        }
+        if(header->type != ScreenMsg::Patch && header->type != ScreenMsg::Keyframe) return false;
+
+        uint8_t decoded[N];
+        if(codec->decode(payload, payload_len, decoded, N) != N) {
+            synced = false;
+            return false;
+        }
+
+        if(header->type == ScreenMsg::Keyframe) memcpy(block, decoded, N);
+        else for(size_t i = 0; i < N; i++) block[i] ^= decoded[i];
+
+        seq = header->seq;
+        synced = true;
+        return true;
+    }
+};
+
+
+/** reassembles packed notifications into the per block decoders */
+template<size_t N, size_t BLOCKS>
+struct ScreenStreamDecoder {
+    ScreenDecoder<N> blocks[BLOCKS];
+
+    /** consumes one notification, false when any segment in it was malformed or dropped */
+    bool decode(const uint8_t *packet, size_t len) {
+        ScreenPacketHeader header;
+        if(len < sizeof(header)) return false;
+        memcpy(&header, packet, sizeof(header));
+        packet += sizeof(header);
+        len -= sizeof(header);
+
+        bool ok = true;
+
+        // a lost notification may have held the middle of any split message
+        if(started && header.seq != (uint8_t)(packet_seq + 1)) {
+            for(size_t block = 0; block < BLOCKS; block++) {
+                if(pending_len[block]) drop(block);
+            }
+            ok = false;
+        }
+        started = true;
+        packet_seq = header.seq;
+
+        while(len >= sizeof(ScreenSegment)) {
+            ScreenSegment segment;
+            memcpy(&segment, packet, sizeof(segment));
+            packet += sizeof(segment);
+            len -= sizeof(segment);
+
+            const size_t block = segment.block & ~SCREEN_SEGMENT_FLAGS;
+            if(block >= BLOCKS || segment.len > len) return false;
+
+            // a new message before the end of the previous one: that one lost its tail
+            if((segment.block & SCREEN_SEGMENT_FIRST) && pending_len[block]) {
+                drop(block);
+                ok = false;
+            }
+
+            // the start of this message was lost, the rest of it is skipped
+            if(!(segment.block & SCREEN_SEGMENT_FIRST) && pending_len[block] == 0) {
+                ok = false;
+            }
+            // an overflowing message means fragments were lost, its decoder waits for a keyframe
+            else if(pending_len[block] + segment.len > sizeof(pending[block])) {
+                drop(block);
+                ok = false;
+            }
+            else {
+                memcpy(pending[block] + pending_len[block], packet, segment.len);
+                pending_len[block] += segment.len;
+
+                if(segment.block & SCREEN_SEGMENT_LAST) {
+                    ok &= blocks[block].decode(pending[block], pending_len[block]);
+                    pending_len[block] = 0;
+                }
+            }
+
+            packet += segment.len;
+            len -= segment.len;
+        }
+
+        return ok && len == 0;
+    }
+
+private:
+    uint8_t pending[BLOCKS][SCREEN_STREAM_MAX_LEN(N)];
+    size_t pending_len[BLOCKS] = {0};
+    uint8_t packet_seq = 0;
+    bool started = false;   // no notification seen yet, any seq is fine
+
+    void drop(size_t block) {
+        pending_len[block] = 0;
+        blocks[block].synced = false;
+    }
+};
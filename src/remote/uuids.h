@@ -2,12 +2,12 @@
 
 #define SERVER_UUID                 "6ceba000-76de-441e-89bc-0de0079db615"
 #define COMMAND_BLECHAR_UUID        "6ceba001-76de-441e-89bc-0de0079db615"
+#define STATS_BLECHAR_UUID          "6ceba002-76de-441e-89bc-0de0079db615"
+#define GLYPHS_BLECHAR_UUID         "6ceba003-76de-441e-89bc-0de0079db615"
+#define PARAMS_BLECHAR_UUID         "6ceba004-76de-441e-89bc-0de0079db615"
 
-#define UUID_BLOCK0                 "6ceba021-76de-441e-89bc-0de0079db615"
-#define UUID_BLOCK1                 "6ceba022-76de-441e-89bc-0de0079db615"
-#define UUID_BLOCK2                 "6ceba023-76de-441e-89bc-0de0079db615"
-#define UUID_BLOCK3                 "6ceba024-76de-441e-89bc-0de0079db615"
+#define SCREEN_BLECHAR_UUID         "6ceba020-76de-441e-89bc-0de0079db615"
 
-const char *UUID_BLOCK[4] = {
-    UUID_BLOCK0, UUID_BLOCK1, UUID_BLOCK2, UUID_BLOCK3
-};
+// ble-midi specification
+#define MIDI_SERVICE_UUID           "03b80e5a-ede8-4b33-a751-6ce34ec4c700"
+#define MIDI_BLECHAR_UUID           "7772e5db-3868-4112-a1a9-f2669d106bf3"
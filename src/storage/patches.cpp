@@ -0,0 +1,146 @@
+#include "patches.hpp"
+#include <cstring>
+#include <Preferences.h>
+#include <esp_log.h>
+
+static const char *PATCH_TAG = "PATCHES";
+static const char *PATCH_NAMESPACE = "patches";
+static const char *ACTIVE_KEY = "active";
+
+static Preferences s_prefs;
+static bool s_ready = false;
+static uint8_t s_active = 0;
+static uint8_t s_stored_active = 0;     // what ACTIVE_KEY holds
+static uint32_t s_active_ms = 0;        // when a load last moved s_active
+
+// autosave state: the last parameter revision seen on the ui and when it last changed
+static uint32_t s_seen_revision = 0;
+static bool s_pending = false;
+static uint32_t s_changed_ms = 0;
+static uint32_t s_written_ms = 0;
+
+static uint8_t s_blob[PATCH_BLOB_MAX];
+static uint8_t s_stored[PATCH_BLOB_MAX];
+
+
+static void slot_key(uint8_t slot, char *key) {
+    snprintf(key, 8, "p%d", slot);
+}
+
+static size_t build_blob(UiController &controller, uint8_t *blob) {
+    ParamValue *values = (ParamValue*)(blob + sizeof(PatchHeader));
+    const size_t count = controller.dump_params(values, PARAM_COUNT);
+
+    const PatchHeader header = { PATCH_VERSION, (uint8_t)count };
+    memcpy(blob, &header, sizeof(header));
+    return sizeof(header) + count * sizeof(ParamValue);
+}
+
+/** the active slot survives a power off once this wrote it */
+static void store_active() {
+    if(s_stored_active == s_active) return;
+    s_prefs.putUChar(ACTIVE_KEY, s_active);
+    s_stored_active = s_active;
+}
+
+/** the current values count as saved, nothing to autosave */
+static void mark_seen(UiController &controller) {
+    s_seen_revision = controller.param_revision();
+    s_pending = false;
+}
+
+
+uint8_t patches::begin() {
+    s_ready = s_prefs.begin(PATCH_NAMESPACE, false);
+    if(!s_ready) {
+        ESP_LOGE(PATCH_TAG, "nvs not available, patches are not kept");
+        return 0;
+    }
+
+    s_stored_active = s_prefs.getUChar(ACTIVE_KEY, 0);
+    s_active = s_stored_active < PATCH_SLOTS ? s_stored_active : 0;
+    return s_active;
+}
+
+uint8_t patches::active_slot() {
+    return s_active;
+}
+
+bool patches::load(UiController &controller, uint8_t slot) {
+    if(!s_ready || slot >= PATCH_SLOTS) return false;
+
+    char key[8];
+    slot_key(slot, key);
+    const size_t len = s_prefs.isKey(key) ? s_prefs.getBytes(key, s_blob, sizeof(s_blob)) : 0;
+
+    PatchHeader header;
+    if(len < sizeof(header)) return false;
+    memcpy(&header, s_blob, sizeof(header));
+
+    if(header.version != PATCH_VERSION || len != sizeof(header) + header.count * sizeof(ParamValue)) {
+        ESP_LOGW(PATCH_TAG, "slot %d: unsupported patch (version %d, %d bytes)", slot, header.version, len);
+        return false;
+    }
+
+    for(size_t i = 0; i < header.count; i++) {
+        ParamValue value;
+        memcpy(&value, s_blob + sizeof(header) + i * sizeof(value), sizeof(value));
+        controller.set_param(value.id, value.raw);
+    }
+
+    // program changes can come in bursts, poll writes the slot once they settled
+    if(s_active != slot) {
+        s_active = slot;
+        s_active_ms = millis();
+    }
+
+    mark_seen(controller);
+    return true;
+}
+
+bool patches::save(UiController &controller, uint8_t slot) {
+    if(!s_ready || slot >= PATCH_SLOTS) return false;
+
+    char key[8];
+    slot_key(slot, key);
+    const size_t len = build_blob(controller, s_blob);
+
+    // nvs appends a new entry on every put, identical patches are not written again
+    const bool same = s_prefs.isKey(key) && s_prefs.getBytesLength(key) == len
+        && s_prefs.getBytes(key, s_stored, sizeof(s_stored)) == len && memcmp(s_stored, s_blob, len) == 0;
+
+    if(!same && s_prefs.putBytes(key, s_blob, len) != len) {
+        ESP_LOGE(PATCH_TAG, "slot %d: write failed", slot);
+        return false;
+    }
+
+    s_active = slot;
+    store_active();
+
+    s_written_ms = millis();
+    mark_seen(controller);
+    return true;
+}
+
+void patches::poll(UiController &controller, bool quiet) {
+    if(!s_ready) return;
+
+    const uint32_t now = millis();
+
+    if(quiet && s_active != s_stored_active && now - s_active_ms >= PATCH_SAVE_DEBOUNCE_MS) {
+        store_active();
+    }
+
+    if(controller.param_revision() != s_seen_revision) {
+        s_seen_revision = controller.param_revision();
+        s_pending = true;
+        s_changed_ms = now;
+        return;
+    }
+
+    // spinning an encoder keeps pushing the write back, and writes are spaced out anyway.
+    // a held note postpones it too, the save goes out after the release
+    if(quiet && s_pending && now - s_changed_ms >= PATCH_SAVE_DEBOUNCE_MS && now - s_written_ms >= PATCH_SAVE_MIN_INTERVAL_MS) {
+        save(controller, s_active);
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cinttypes>
+#include <cstddef>
+#include "config.h"
+#include "ui/UiController.hpp"
+
+/**
+ * patches live in nvs as one blob per slot: a header followed by {id, raw} pairs (see ParamValue).
+ * ids missing from an older patch keep their current value and unknown ids are skipped,
+ * so adding parameters does not need a version bump. the synth config is rebuilt from the widgets.
+ */
+#define PATCH_VERSION 1
+
+struct __attribute__((packed)) PatchHeader {
+    uint8_t version;
+    uint8_t count;
+};
+
+#define PATCH_BLOB_MAX (sizeof(PatchHeader) + PARAM_COUNT * sizeof(ParamValue))
+
+namespace patches {
+    /** opens the nvs namespace, returns the slot that was active at the last power off */
+    uint8_t begin();
+
+    /**
+     * all runs on the ui task. a load sets every widget before the loop sends the config,
+     * so the audio task gets the whole patch in one update
+     */
+    bool load(UiController &controller, uint8_t slot);
+    bool save(UiController &controller, uint8_t slot);
+    uint8_t active_slot();
+
+    /**
+     * saves the active slot once the parameters stopped changing and records which slot is active, call every ui frame.
+     * an nvs write stalls the flash cache, so nothing is written unless quiet (no voice sounding)
+     */
+    void poll(UiController &controller, bool quiet);
+};
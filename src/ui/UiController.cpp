@@ -3,145 +3,6 @@
 #include "audio/wavetable.hpp"
 #include "audio/audio_math.hpp"
 
-// ---------- DIVISION SELECTOR ----------
-static const char* division_labels[] = {"1", "1/2", "1/4", "1/8"};
-static int32_t division_values[] =     {1,     2,     4,     8};
-
-static const SelectorConfig division_config = {
-    .display_values = division_labels,
-    .values = division_values,
-    .norm_factor = 1,
-    .count = 4,
-    .default_index = 0    // "1"
-};
-
-
-// ---------- TEMPO SELECTOR ----------
-static const char* tempo_labels[] = {"80", "100", "120", "130", "150"};
-static int32_t tempo_values[] =     { 80,   100,   120,   130,   150 };
-
-static const SelectorConfig tempo_config = {
-    .display_values = tempo_labels,
-    .values = tempo_values,
-    .norm_factor = 1,
-    .count = 5,
-    .default_index = 2  // "120" BPM
-};
-
-
-// ---------- GAIN SELECTOR ----------
-static const char* gain_labels[] = {"0.0", "0.1", "0.2", "0.3", "0.4", "0.5", "0.6", "0.7", "0.8", "0.9", "1.0"};
-static int32_t gain_values[] =     {0,        10,    20,    30,    40,    50,    60,    70,    80,    90,  100};
-static const SelectorConfig gain_config = {
-    .display_values = gain_labels,
-    .values = gain_values,
-    .norm_factor = 100,
-    .count = 11,
-    .default_index = 5 // "0.5"
-};
-
-// ---------- SHAPE SELECTOR ----------
-static const char* shape_labels[] = {"tri", "t_s", "saw", "squ", "re1", "re2"};
-static int32_t shape_values[] = {
-    WaveIndex::Tri,
-    WaveIndex::TriSaw,
-    WaveIndex::Saw,
-    WaveIndex::Square,
-    WaveIndex::RectWide,
-    WaveIndex::RectNarrow
-};
-static const SelectorConfig shape_config = {
-    .display_values = shape_labels,
-    .values = shape_values,
-    .norm_factor = 1,
-    .count = 6,
-    .default_index = 0
-};
-
-// ---------- DETUNE SELECTOR ----------
-static const char* detune_labels[] = {"-20", "-16", "-12", "-10", "-7", "-5", "-3", "0"};
-static int32_t detune_values[] =     {-20, -16, -12, -10, -7, -5, -3, 0};
-static const SelectorConfig detune_config = {
-    .display_values = detune_labels,
-    .values = detune_values,
-    .norm_factor = 100,
-    .count = 8,
-    .default_index = 7
-};
-
-// ---------- RANGE SELECTOR ----------
-static const char* range_labels[] = {"32'", "16'", "8'", "4'", "2'"};
-static int32_t range_values[] = {32, 16, 8, 4, 2};
-static const SelectorConfig range_config = {
-    .display_values = range_labels,
-    .values = range_values,
-    .norm_factor = 8,
-    .count = 5,
-    .default_index = 2 // "8'"
-};
-
-// ---------- TIME SELECTOR ----------
-static const char* time_labels[] = {
-    "0.1s", "0.2s", "0.3s", "0.4s", "0.5s", "0.6s", "0.7s", "0.8s", "0.9s", "1s",
-    "2s", "3s", "4s", "5s", "8s", "10s", "15s", "30s", "60s"
-};
-static int32_t time_values[] = {
-    100, 200, 300, 400, 500, 600, 700, 800, 900, 1000,
-    2000, 3000, 4000, 5000, 8000, 10000, 15000, 30000, 60000
-};
-static const SelectorConfig time_config = {
-    .display_values = time_labels,
-    .values         = time_values,
-    .norm_factor    = 1000,
-    .count          = sizeof(time_values) / sizeof(time_values[0]),
-    .default_index  = 9 // "1s"
-};
-
-// ---------- BOOST -----------
-static const char* boost_labels[] = {"+0", "+1", "+2"};
-static int32_t boost_values[] = {10, 15, 20};
-static const SelectorConfig boost_config = {
-    .display_values = boost_labels,
-    .values = boost_values,
-    .norm_factor = 10,
-    .count = 3,
-    .default_index = 0
-};
-
-
-// --------- FILTER ----------
-static const char* contour_labels[] = {
-    "none", "+100", "+500", "+1k", "+2k", "+3k", "+4k"
-};
-static int32_t contour_values[] = {
-    0, 100, 500, 1000, 2000, 3000, 4000
-};
-static const SelectorConfig contour_config = {
-    .display_values = contour_labels,
-    .values         = contour_values,
-    .norm_factor    = 1,
-    .count          = sizeof(contour_values) / sizeof(contour_values[0]),
-    .default_index  = 0  // none
-};
-
-
-static const char* cutoff_labels[] = {
-    "1kHz", "2kHz", "3kHz", "4kHz", "5kHz", "6kHz", "7kHz",
-    "8kHz", "9kHz", "10kHz", "12kHz", "15kHz", "18kHz"
-};
-static int32_t cutoff_values[] = {
-    1000, 2000, 3000, 4000, 5000, 6000, 7000,
-    8000, 9000, 10000, 12000, 15000, 18000
-};
-static const SelectorConfig cutoff_config = {
-    .display_values = cutoff_labels,
-    .values         = cutoff_values,
-    .norm_factor    = 1,
-    .count          = sizeof(cutoff_values) / sizeof(cutoff_values[0]),
-    .default_index  = 9 // Starts at 1kHz
-};
-
-
 // ---------- Layout Constants ----------
 static const int16_t COL1 = 6;
 static const int16_t COL2 = 128 / 2 - 16;
@@ -152,26 +13,29 @@ static const int16_t ROW1 = 44;
 struct Table2x3Layout {
     Widget *table[2][3] = { nullptr };
 
-    inline void first_row(Widget *c1, Widget *c2, Widget *c3) {
-        table[0][0] = c1; table[0][1] = c2; table[0][2] = c3;
+    /** slots 0-2 on the first row, 3-5 on the shifted one */
+    inline void place(size_t slot, Widget *widget) {
+        static const int16_t cols[3] = { COL1, COL2, COL3 };
+        static const int16_t rows[2] = { ROW1, ROW2 };
 
-        if(c1) { c1->x = COL1; c1->y = ROW1; }
-        if(c2) { c2->x = COL2; c2->y = ROW1; }
-        if(c3) { c3->x = COL3; c3->y = ROW1; }
+        table[slot / 3][slot % 3] = widget;
+        widget->x = cols[slot % 3];
+        widget->y = rows[slot / 3];
     }
 
-    inline void second_row(Widget *c1, Widget *c2, Widget * c3) {
-        table[1][0] = c1; table[1][1] = c2; table[1][2] = c3;
-
-        if(c1) { c1->x = COL1; c1->y = ROW2; }
-        if(c2) { c2->x = COL2; c2->y = ROW2; }
-        if(c3) { c3->x = COL3; c3->y = ROW2; }
+    void render(Adafruit_SSD1306 *gfx) {
+        for(size_t i = 0; i < 2; i++)
+            for(size_t j = 0; j < 3; j++)
+                if(table[i][j]) {
+                    table[i][j]->render(gfx);
+                    table[i][j]->dirty = false;
+                }
     }
 
-    void render(Adafruit_SSD1306 *gfx) {
+    void render_dirty(Adafruit_SSD1306 *gfx, DirtyRegion &region) {
         for(size_t i = 0; i < 2; i++)
             for(size_t j = 0; j < 3; j++)
-                if(table[i][j]) table[i][j]->render(gfx);
+                if(table[i][j]) table[i][j]->render_dirty(gfx, region);
     }
 
     void process_event(const InputEvent &event) {
@@ -187,180 +51,119 @@ struct Table2x3Layout {
 // =============================
 // || TABS
 // =============================
-struct ArpTab : Widget {
-    ArpeggiatorConfig *config;
-
-    Switch   en       = Switch  ("en");
-    Selector division = Selector("div",  division_config);
-    Selector tempo    = Selector("bpm",  tempo_config);
-
+/** a tab of up to 6 parameters, filled from the schema */
+struct LayoutTab : Widget {
     Table2x3Layout layout;
 
-    ArpTab(const char* key, ArpeggiatorConfig *config = nullptr) : Widget(key, 0, 0), config(config) {
-        layout.first_row(&en, &division, &tempo);
-    }
+    LayoutTab() : Widget(nullptr, 0, 0) {}
 
     virtual void render(Adafruit_SSD1306 *gfx) override {
-        layout.render(gfx); 
-    }
-
-    virtual void process_event(const InputEvent &event) override {
-        layout.process_event(event);
-        update_configs();
-    }
-
-    void update_configs() {
-        config->enabled = en.get_value();
-        config->time_division = division.get_value();
-        config->tempo_bpm = tempo.get_value();
-    }
-};
-
-
-struct OscTab : Widget {
-    OscillatorConfig *config;
-
-    Selector range   = Selector("octv",  range_config);
-    Selector detune  = Selector("tune",  detune_config);
-    Selector shape   = Selector("shp",   shape_config);
-    Selector gain    = Selector("gain",  gain_config);
-    Switch   en      = Switch  ("en");
-
-    Table2x3Layout layout;
-
-    OscTab(const char* key, OscillatorConfig *config = nullptr) : Widget(key, 0, 0), config(config) {
-        layout.first_row(&range, &detune, &shape);
-        layout.second_row(nullptr, &gain, &en);
+        layout.render(gfx);
     }
 
-    virtual void render(Adafruit_SSD1306 *gfx) override {
-        layout.render(gfx); 
+    virtual void render_dirty(Adafruit_SSD1306 *gfx, DirtyRegion &region) override {
+        layout.render_dirty(gfx, region);
     }
 
     virtual void process_event(const InputEvent &event) override {
         layout.process_event(event);
-        update_configs();
     }
 
-    void update_configs() {
-        config->set_freq_mult(1.f/range.get_value_asf32(), detune.get_value());
-        config->wave_index = shape.get_value();
-        config->gain_mult = volume_to_gain(gain.get_value_asf32());
-        config->enabled = en.get_value();
+    Widget *slot(size_t index) {
+        if(index >= PARAM_SLOTS) return nullptr;
+        return layout.table[index / 3][index % 3];
     }
 };
 
 
-struct EnvTab : Widget {
-    EnvelopeConfig *env_cfg;
-    BoostConfig *boost_cfg;
-
-    Selector attack  = Selector("att", time_config);
-    Selector decay   = Selector("dec", time_config);
-    Selector sustain = Selector("sus", gain_config);
-
-    Selector boost_en = Selector("bst",   boost_config);
-    Selector gain     = Selector("gain",  gain_config);
-
-    Table2x3Layout layout;
-
-    EnvTab(const char* key, EnvelopeConfig *env_cfg, BoostConfig *boost_cfg) 
-        : Widget(key, 0, 0), env_cfg(env_cfg), boost_cfg(boost_cfg) {
-            layout.first_row(&attack, &decay, &sustain);
-            layout.second_row(nullptr, &boost_en, &gain);
-            gain.index = 10;
-        }
-
-    virtual void render(Adafruit_SSD1306 *gfx) override {
-        layout.render(gfx);   
-    }
-
-    virtual void process_event(const InputEvent &event) override {
-        layout.process_event(event);
-        update_configs();
-    }
+// one widget per parameter and the knob and selector configs, declared by the schema
+#include "ui/generated/param_widgets.hpp"
 
-    void update_configs() {
-        env_cfg->attack_secs = attack.get_value_asf32();
-        env_cfg->decay_secs = decay.get_value_asf32();
-        env_cfg->sustain_gain = sustain.get_value_asf32();
-        env_cfg->release_secs = decay.get_value_asf32() * 2;
+static LayoutTab layout_tabs[TAB_COUNT];
 
-        boost_cfg->boost_mult = boost_en.get_value_asf32();
-        boost_cfg->gain_mult  = volume_to_gain(gain.get_value_asf32());
-    }
-};
+// dense index of every tab slot, -1 when empty
+static int8_t slot_index[TAB_COUNT][PARAM_SLOTS];
 
-struct FltTab : Widget {
-    LowPassConfig *config;
-
-    Selector attack  = Selector("att", time_config);
-    Selector decay   = Selector("dec", time_config);
-    Selector sustain = Selector("sus", gain_config);
+static int32_t param_index(uint16_t id) {
+    const uint8_t tab = id >> 8;
+    const uint8_t slot = id & 0xFF;
+    if(tab >= TAB_COUNT || slot >= PARAM_SLOTS) return -1;
+    return slot_index[tab][slot];
+}
 
-    Selector cutoff    = Selector("cut",   cutoff_config);
-    Selector resonance = Selector("res",   gain_config);
-    Selector contour   = Selector("cou",  contour_config);
 
-    Table2x3Layout layout;
+// =============================
+// || CONFIG MAPPING
+// =============================
+static void apply_osc(OscillatorConfig &config, Selector &range, Knob &detune, Selector &shape, Knob &pan, Knob &gain, Switch &en) {
+    config.set_freq_mult(1.f/range.get_value_asf32(), detune.get_value());
+    config.wave_index = shape.get_value();
+    config.gain_mult = volume_to_gain(gain.get_value());
+    config.set_pan(pan.get_value());
+    config.enabled = en.get_value();
+}
 
-    FltTab(const char* key, LowPassConfig *config) 
-        : Widget(key, 0, 0), config(config) {
-            layout.first_row(&cutoff, &resonance, &contour);
-            layout.second_row(&attack, &decay, &sustain);
-            resonance.index = 3;
+/** writes the widget values of a tab into the synth config */
+static void apply_tab(uint8_t tab, SynthConfig &config) {
+    switch(tab) {
+        case Tab::Input: {
+            config.arpeggiator.enabled = arp_enabled.get_value();
+            config.arpeggiator.time_division = arp_division.get_value();
+            config.arpeggiator.tempo_bpm = arp_tempo.get_value();
+            break;
+        }
+        case Tab::Osc1: return apply_osc(config.osc1, osc1_range, osc1_detune, osc1_shape, osc1_pan, osc1_gain, osc1_enabled);
+        case Tab::Osc2: return apply_osc(config.osc2, osc2_range, osc2_detune, osc2_shape, osc2_pan, osc2_gain, osc2_enabled);
+        case Tab::Osc3: return apply_osc(config.osc3, osc3_range, osc3_detune, osc3_shape, osc3_pan, osc3_gain, osc3_enabled);
+        case Tab::Envelope: {
+            config.envelope.attack_secs = env_attack.get_value();
+            config.envelope.decay_secs = env_decay.get_value();
+            config.envelope.sustain_gain = env_sustain.get_value();
+            config.envelope.release_secs = env_decay.get_value() * 2;
+
+            config.boost.boost_mult = env_boost.get_value_asf32();
+            config.boost.gain_mult  = volume_to_gain(env_gain.get_value());
+            break;
+        }
+        case Tab::Filter: {
+            LowPassConfig &lowpass = config.lowpass;
+            lowpass.cutoff_envelope.attack_secs =  flt_attack.get_value();
+            lowpass.cutoff_envelope.decay_secs =   flt_decay.get_value();
+            lowpass.cutoff_envelope.sustain_gain = flt_sustain.get_value();
+            lowpass.cutoff_envelope.release_secs = flt_decay.get_value() / 2;
+
+            lowpass.cutoff_hz     = flt_cutoff.get_value();
+            lowpass.emphasis_perc = flt_resonance.get_value();
+            lowpass.countour_dhz  = flt_contour.get_value();
+            break;
+        }
+        case Tab::Effects: {
+            config.effects.delay.mix      = fx_delay.get_value();
+            config.effects.delay.feedback = fx_feedback.get_value();
+            config.effects.delay.beats    = fx_beats.get_value_asf32();
+
+            config.effects.chorus.mix  = fx_chorus.get_value();
+            config.effects.reverb.mix  = fx_reverb.get_value();
+            config.effects.reverb.size = fx_size.get_value();
+            break;
         }
-
-    virtual void render(Adafruit_SSD1306 *gfx) override {
-        layout.render(gfx);   
-    }
-
-    virtual void process_event(const InputEvent &event) override {
-        layout.process_event(event);
-        update_configs();
     }
+}
 
-    void update_configs() {
-        config->cutoff_envelope.attack_secs =  attack.get_value_asf32();
-        config->cutoff_envelope.decay_secs =   decay.get_value_asf32();
-        config->cutoff_envelope.sustain_gain = sustain.get_value_asf32();
-        config->cutoff_envelope.release_secs = decay.get_value_asf32() / 2;
 
-        config->cutoff_hz   = cutoff.get_value_asf32();
-        config->emphasis_perc = resonance.get_value_asf32();
-        config->countour_dhz = contour.get_value_asf32();
+void UiController::init() {
+    static_assert(ParamIndex::Count <= 64, "change masks are 64 bit");
+    memset(slot_index, -1, sizeof(slot_index));
+
+    for(size_t i = 0; i < PARAM_COUNT; i++) {
+        const ParamSpec &spec = PARAM_SPECS[i];
+        layout_tabs[spec.tab].layout.place(spec.slot, param_widgets[i]);
+        slot_index[spec.tab][spec.slot] = i;
+        param_raw[i] = param_widgets[i]->get_raw();
     }
-};
-
-
-static auto arp_tab  = ArpTab("arp", nullptr);
-static auto osc1_tab = OscTab("o1",  nullptr);
-static auto osc2_tab = OscTab("o2",  nullptr);
-static auto osc3_tab = OscTab("o3",  nullptr);
-static auto env_tab  = EnvTab("env", nullptr, nullptr);
-static auto flt_tab  = FltTab("flt", nullptr);
-
-static auto tabs = WidgetGroup();
-
 
-void UiController::init() {
-    arp_tab.config  = &config.arpeggiator;
-    osc1_tab.config = &config.osc1;
-    osc2_tab.config = &config.osc2;
-    osc3_tab.config = &config.osc3;
-    env_tab.env_cfg =  &config.envelope;
-    env_tab.boost_cfg = &config.boost;
-    flt_tab.config = &config.lowpass;
-
-    tabs.add(&arp_tab);
-    tabs.add(&osc1_tab);
-    tabs.add(&osc2_tab);
-    tabs.add(&osc3_tab);
-    tabs.add(&env_tab);
-    tabs.add(&flt_tab);
-
-    osc1_tab.en.nudge(1);
-    osc1_tab.update_configs();
+    for(uint8_t tab = 0; tab < TAB_COUNT; tab++)
+        apply_tab(tab, config);
 }
 
 
@@ -388,19 +191,34 @@ void UiController::process_event(const InputEvent &event) {
         }
         // handle encoder values
         default: {
-            Widget *active_tab = tabs.get(tab_index);
-            if(active_tab) active_tab->process_event(event);
+            layout_tabs[tab_index].process_event(event);
         }
     }
 }
 
 
-bool UiController::render_to_buffer() {
+bool UiController::render_to_buffer(DirtyRegion &region) {
+    LayoutTab &active_tab = layout_tabs[tab_index];
+
+    // same tab and layer: only widgets whose value changed are redrawn
+    if(drawn_once && drawn_tab == tab_index && drawn_shift == layer_shift_on) {
+        active_tab.render_dirty(gfx, region);
+        // the boxes of the right column reach x = 126, the cleared indicator goes back on top like a full redraw
+        if(!region.empty()) render_layer_indicator();
+        return !region.empty();
+    }
+
+    drawn_once = true;
+    drawn_tab = tab_index;
+    drawn_shift = layer_shift_on;
+    gfx->clearDisplay();
+    region.all();
+
     // render header
     int16_t x = 1;
     for(size_t i = 0; i < TAB_COUNT; i++) {
         const char *tab_name  = tab_names[i];
-        const int16_t spacing = strlen(tab_name) * 9;
+        const int16_t spacing = strlen(tab_name) * 6 + 3;
       
         gfx->setCursor(x, 0);
         gfx->print(tab_names[i]);
@@ -412,7 +230,15 @@ bool UiController::render_to_buffer() {
         x += spacing;
     }
 
-    // render layer indicator
+    render_layer_indicator();
+
+    // render correct tab
+    active_tab.render(gfx);
+
+    return true;
+}
+
+void UiController::render_layer_indicator() {
     const int16_t y0 = layer_shift_on ? 18-1 : 46-1;
     const int16_t w = 1;
     const int16_t h = 3;
@@ -422,10 +248,100 @@ bool UiController::render_to_buffer() {
         gfx->fillRect(0,       yi,  w, h, SSD1306_WHITE);
         gfx->fillRect(128-w-1, yi,  w, h, SSD1306_WHITE);
     }
+}
 
-    // render correct tab
-    Widget *active_tab = tabs.get(tab_index);
-    if(active_tab) active_tab->render(gfx);
 
+void UiController::commit(size_t index, int32_t raw) {
+    param_raw[index] = raw;
+    notify_mask |= 1ull << index;
+    revision++;
+
+    apply_tab(PARAM_SPECS[index].tab, config);
+    config_changed = true;
+}
+
+bool UiController::sync() {
+    for(size_t i = 0; i < PARAM_COUNT; i++) {
+        const int32_t raw = param_widgets[i]->get_raw();
+        if(raw != param_raw[i]) commit(i, raw);
+    }
+
+    const bool changed = config_changed;
+    config_changed = false;
+    return changed;
+}
+
+
+bool UiController::get_param(uint16_t id, int32_t *raw) {
+    const int32_t index = param_index(id);
+    if(index < 0) return false;
+
+    *raw = param_raw[index];
     return true;
 }
+
+bool UiController::set_param(uint16_t id, int32_t raw) {
+    const int32_t index = param_index(id);
+    if(index < 0) return false;
+
+    Widget *widget = param_widgets[index];
+    widget->set_raw(raw);
+    if(widget->get_raw() != param_raw[index]) commit(index, widget->get_raw());
+    return true;
+}
+
+size_t UiController::dump_params(ParamValue *out, size_t len) {
+    size_t count = 0;
+
+    for(size_t i = 0; i < PARAM_COUNT && count < len; i++)
+        out[count++] = { param_id(PARAM_SPECS[i].tab, PARAM_SPECS[i].slot), param_raw[i] };
+
+    return count;
+}
+
+size_t UiController::changed_params(ParamValue *out, size_t len) {
+    size_t count = 0;
+
+    for(size_t i = 0; i < PARAM_COUNT && count < len; i++) {
+        if(!(notify_mask & (1ull << i))) continue;
+
+        notify_mask &= ~(1ull << i);
+        out[count++] = { param_id(PARAM_SPECS[i].tab, PARAM_SPECS[i].slot), param_raw[i] };
+    }
+
+    return count;
+}
+
+bool UiController::control_change(uint8_t cc, uint8_t value) {
+    for(size_t i = 0; i < PARAM_COUNT; i++) {
+        if(PARAM_SPECS[i].cc != cc) continue;
+
+        const int32_t max = param_widgets[i]->get_raw_max();
+        return set_param(param_id(PARAM_SPECS[i].tab, PARAM_SPECS[i].slot), (value * max + 63) / 127);
+    }
+
+    return false;
+}
+
+
+static const char *GLYPH_LINES[] = {
+    "0123456789.+-ksabcdef",
+    "ghilmnoprtuvwxyzLRONF",
+};
+
+size_t UiController::render_glyphs(uint8_t *dest, size_t len) {
+    if(len < GLYPH_DICT_SIZE) return 0;
+
+    // rows 0, 12, 24, 36: pages 0-2 hold the first line twice, pages 3-5 the second
+    gfx->clearDisplay();
+    for(size_t i = 0; i < 2; i++) {
+        gfx->setCursor(0, i * 24);
+        gfx->print(GLYPH_LINES[i]);
+        gfx->setCursor(0, i * 24 + 12);
+        gfx->print(GLYPH_LINES[i]);
+    }
+
+    memcpy(dest, gfx->getBuffer(), GLYPH_DICT_SIZE);
+    gfx->clearDisplay();
+    return GLYPH_DICT_SIZE;
+}
@@ -5,29 +5,41 @@
 #include "ui/widget.hpp"
 #include "input/events.hpp"
 #include "audio/synth.hpp"
+#include "ui/generated/params.hpp"
 
 
-namespace Tab {
-    enum Value {
-        Input,
-        Osc1,
-        Osc2,
-        Osc3,
-        Envelope,
-        Filter,
-    };
-};
+// parameters are addressed by tab and slot: id = tab << 8 | slot. the schema is generation/params.py
+#define PARAM_SLOTS 6
+#define PARAM_COUNT ((size_t)ParamIndex::Count)
+
+inline uint16_t param_id(uint8_t tab, uint8_t slot) { return tab << 8 | slot; }
 
-constexpr const char* tab_names[] = {
-    "arp", "o1", "o2", "o3", "env", "flt"
+struct __attribute__((packed)) ParamValue {
+    uint16_t id;
+    int32_t  raw;   // see Widget::get_raw
 };
 
-const uint8_t TAB_COUNT = Tab::Filter + 1;
+// glyphs at both vertical alignments the widgets use (page aligned and 4 rows down), 3 pages per line
+#define GLYPH_DICT_SIZE (2 * 3 * 128)
 
 class UiController {
     Adafruit_SSD1306 *gfx;
     Tab::Value tab_index = Tab::Osc1;
-    bool layer_shift_on;
+    bool layer_shift_on = false;
+
+    // what the frame buffer currently shows, a change forces a full redraw
+    bool drawn_once = false;
+    Tab::Value drawn_tab = Tab::Osc1;
+    bool drawn_shift = false;
+
+    // flat parameter state, indexed by ParamIndex
+    int32_t  param_raw[PARAM_COUNT] = {0};
+    uint64_t notify_mask = 0;       // changed since the last changed_params
+    uint32_t revision = 0;          // bumped on every change
+    bool config_changed = false;    // since the last sync
+
+    void commit(size_t index, int32_t raw);
+    void render_layer_indicator();
 
 public:
     SynthConfig config;
@@ -35,5 +47,24 @@ public:
 
     void init();
     void process_event(const InputEvent &event);
-    bool render_to_buffer();
+    /** folds widget changes into the parameters and the synth config, true when the config changed */
+    bool sync();
+    /** draws what changed since the last call into the frame buffer, false when nothing did */
+    bool render_to_buffer(DirtyRegion &region);
+
+    /** false for ids without a widget */
+    bool get_param(uint16_t id, int32_t *raw);
+    /** clamps, redraws and updates the synth config like an encoder turn would */
+    bool set_param(uint16_t id, int32_t raw);
+    /** every parameter, returns how many were written */
+    size_t dump_params(ParamValue *out, size_t len);
+    /** parameters whose value changed since the previous call, from any source */
+    size_t changed_params(ParamValue *out, size_t len);
+    /** counts every parameter change, cheaper to compare than the values */
+    uint32_t param_revision() const { return revision; }
+    /** midi control change, the value is scaled over the whole range of the mapped parameter */
+    bool control_change(uint8_t cc, uint8_t value);
+
+    /** draws the characters the ui uses into dest in page format, the screen codecs use it as a dictionary */
+    size_t render_glyphs(uint8_t *dest, size_t len);
 };
@@ -0,0 +1,95 @@
+#include "display.hpp"
+#include <cstring>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/i2c.h"
+#include "config.h"
+
+// ------- BUS --------
+#define DISPLAY_I2C_TIMEOUT_MS 20
+#define DISPLAY_CMD_LINK_SIZE  I2C_LINK_RECOMMENDED_SIZE(6)
+
+bool I2cDisplayBus::write_window(uint8_t page, uint8_t col_start, uint8_t col_end, const uint8_t *data) {
+    static uint8_t s_link_buffer[DISPLAY_CMD_LINK_SIZE];
+
+    const uint8_t window[] = {
+        0x00,   // co = 0, d/c = 0: command stream
+        SSD1306_PAGEADDR,   page,      page,
+        SSD1306_COLUMNADDR, col_start, col_end,
+    };
+    const uint8_t data_stream = 0x40;   // co = 0, d/c = 1: data stream
+    const uint8_t addr_write = (addr << 1) | I2C_MASTER_WRITE;
+
+    // horizontal addressing mode: the data wraps inside the window set by the first half
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(s_link_buffer, sizeof(s_link_buffer));
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, addr_write, true);
+    i2c_master_write(cmd, window, sizeof(window), true);
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, addr_write, true);
+    i2c_master_write_byte(cmd, data_stream, true);
+    i2c_master_write(cmd, data, col_end - col_start + 1, true);
+    i2c_master_stop(cmd);
+
+    const esp_err_t err = i2c_master_cmd_begin((i2c_port_t)port, cmd, pdMS_TO_TICKS(DISPLAY_I2C_TIMEOUT_MS));
+    i2c_cmd_link_delete_static(cmd);
+    return err == ESP_OK;
+}
+
+
+// ------- FLUSH --------
+static DisplayBus *s_bus = nullptr;
+static TaskHandle_t s_flush_task = nullptr;
+static SemaphoreHandle_t s_pending_mutex = nullptr;
+
+// pages are copied whole, so merged regions never send columns that were not copied
+static uint8_t s_pending[SCREEN_BUFFER_SIZE];
+static DirtyRegion s_pending_region;
+static uint8_t s_sending[SCREEN_BUFFER_SIZE];
+
+void oled::begin(DisplayBus *bus) {
+    s_bus = bus;
+    s_pending_mutex = xSemaphoreCreateMutex();
+}
+
+void oled::submit(const uint8_t *buffer, const DirtyRegion &region) {
+    if(region.empty() || !s_pending_mutex) return;
+
+    xSemaphoreTake(s_pending_mutex, portMAX_DELAY);
+    for(uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+        if(region.pages & (1 << page))
+            memcpy(s_pending + page * DISPLAY_WIDTH, buffer + page * DISPLAY_WIDTH, DISPLAY_WIDTH);
+    }
+
+    s_pending_region.pages |= region.pages;
+    s_pending_region.col_start = region.col_start < s_pending_region.col_start ? region.col_start : s_pending_region.col_start;
+    s_pending_region.col_end   = region.col_end   > s_pending_region.col_end   ? region.col_end   : s_pending_region.col_end;
+    xSemaphoreGive(s_pending_mutex);
+
+    if(s_flush_task) xTaskNotifyGive(s_flush_task);
+}
+
+void oled::flush_task(void *arg) {
+    s_flush_task = xTaskGetCurrentTaskHandle();
+
+    while(true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // take everything pending, the ui can keep submitting while the bus is busy
+        xSemaphoreTake(s_pending_mutex, portMAX_DELAY);
+        const DirtyRegion region = s_pending_region;
+        for(uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+            if(region.pages & (1 << page))
+                memcpy(s_sending + page * DISPLAY_WIDTH, s_pending + page * DISPLAY_WIDTH, DISPLAY_WIDTH);
+        }
+        s_pending_region = DirtyRegion();
+        xSemaphoreGive(s_pending_mutex);
+
+        for(uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+            if(!(region.pages & (1 << page))) continue;
+            const uint8_t *row = s_sending + page * DISPLAY_WIDTH + region.col_start;
+            s_bus->write_window(page, region.col_start, region.col_end, row);
+        }
+    }
+}
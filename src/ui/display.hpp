@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <Arduino.h>
+#include <Adafruit_SSD1306.h>
+
+#define DISPLAY_WIDTH  128
+#define DISPLAY_HEIGHT 64
+#define DISPLAY_PAGES  (DISPLAY_HEIGHT / 8)
+
+/** part of the frame buffer that changed: a mask of 8 pixel pages and one column range shared by them */
+struct DirtyRegion {
+    uint8_t pages = 0;
+    uint8_t col_start = DISPLAY_WIDTH - 1;
+    uint8_t col_end = 0;
+
+    void add(int16_t x, int16_t y, int16_t w, int16_t h) {
+        const int16_t x0 = constrain(x, 0, DISPLAY_WIDTH - 1);
+        const int16_t x1 = constrain(x + w - 1, 0, DISPLAY_WIDTH - 1);
+        const int16_t p0 = constrain(y, 0, DISPLAY_HEIGHT - 1) / 8;
+        const int16_t p1 = constrain(y + h - 1, 0, DISPLAY_HEIGHT - 1) / 8;
+        if(x1 < x0 || p1 < p0) return;
+
+        for(int16_t p = p0; p <= p1; p++) pages |= 1 << p;
+        col_start = x0 < col_start ? x0 : col_start;
+        col_end   = x1 > col_end   ? x1 : col_end;
+    }
+
+    void all() {
+        pages = 0xFF;
+        col_start = 0;
+        col_end = DISPLAY_WIDTH - 1;
+    }
+
+    bool empty() const { return pages == 0; }
+};
+
+// ------- BUS --------
+/** destination of flushed pages, the flush task only talks to this */
+class DisplayBus {
+public:
+    /** writes data into one page between col_start and col_end included, blocks until done */
+    virtual bool write_window(uint8_t page, uint8_t col_start, uint8_t col_end, const uint8_t *data) = 0;
+    virtual ~DisplayBus() = default;
+};
+
+/** ssd1306 on an already installed idf i2c port, command links live in static buffers so no heap is touched */
+class I2cDisplayBus : public DisplayBus {
+public:
+    I2cDisplayBus(int port, uint8_t addr) : port(port), addr(addr) {}
+    bool write_window(uint8_t page, uint8_t col_start, uint8_t col_end, const uint8_t *data) override;
+
+private:
+    int port;
+    uint8_t addr;
+};
+
+
+// ------- FLUSH --------
+namespace oled {
+    void begin(DisplayBus *bus);
+
+    /** copies the dirty pages for the flush task and returns at once, regions queue up while the bus is busy */
+    void submit(const uint8_t *buffer, const DirtyRegion &region);
+
+    /** owns the bus: waits for a submit, then streams the pending pages */
+    void flush_task(void *arg);
+};
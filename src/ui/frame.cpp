@@ -0,0 +1,23 @@
+#include "frame.hpp"
+#include <cstring>
+
+FrameDiff FrameManager::commit(const uint8_t *back) {
+    FrameDiff diff;
+
+    for(uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+        const uint8_t *src = back + page * DISPLAY_WIDTH;
+        uint8_t *dst = front_buffer + page * DISPLAY_WIDTH;
+        if(memcmp(src, dst, DISPLAY_WIDTH) == 0) continue;
+
+        // narrow down to the first and last changed column
+        int16_t first = 0;
+        int16_t last = DISPLAY_WIDTH - 1;
+        while(src[first] == dst[first]) first++;
+        while(src[last] == dst[last]) last--;
+
+        diff.region.add(first, page * 8, last - first + 1, 8);
+        memcpy(dst, src, DISPLAY_WIDTH);
+    }
+
+    return diff;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include "config.h"
+#include "ui/display.hpp"
+
+/** what changed between two published frames, pages are the unit both the panel and the remote send */
+struct FrameDiff {
+    DirtyRegion region;
+
+    bool empty() const { return region.empty(); }
+    uint8_t pages() const { return region.pages; }
+};
+
+/**
+ * double buffer: the gfx buffer is the back one the ui draws into, front holds the last published frame.
+ * the diff is computed once per frame and shared by every consumer.
+ */
+class FrameManager {
+public:
+    /** diffs back against front page by page and publishes the changed pages */
+    FrameDiff commit(const uint8_t *back);
+    const uint8_t *front() const { return front_buffer; }
+
+private:
+    uint8_t front_buffer[SCREEN_BUFFER_SIZE] = {0};
+};
@@ -0,0 +1,155 @@
+#pragma once
+// generated by generation/params.py, edit the schema there
+// included by UiController.cpp, after widget.hpp and wavetable.hpp (shape values)
+#include "params.hpp"
+
+// ---------- KNOBS ----------
+static const KnobConfig level_config   = { 0.f, 1.f, Curve::Linear, format_ratio, 0.5f };
+static const KnobConfig mix_config     = { 0.f, 1.f, Curve::Linear, format_ratio, 0.f };
+static const KnobConfig detune_config  = { -50.f, 50.f, Curve::Linear, format_cents, 0.f };
+static const KnobConfig pan_config     = { -1.f, 1.f, Curve::Linear, format_pan, 0.f };
+static const KnobConfig time_config    = { 0.01f, 60.f, Curve::Log, format_secs, 1.f };
+static const KnobConfig cutoff_config  = { 50.f, 18000.f, Curve::Log, format_hz, 10000.f };
+static const KnobConfig contour_config = { 0.f, 4000.f, Curve::Linear, format_hz, 0.f };
+
+// ---------- SELECTORS ----------
+static const char* division_labels[] = { "1", "1/2", "1/4", "1/8" };
+static int32_t division_values[] = { 1, 2, 4, 8 };
+static const SelectorConfig division_config = {
+    .display_values = division_labels,
+    .values         = division_values,
+    .norm_factor    = 1,
+    .count          = 4,
+    .default_index  = 0   // "1"
+};
+
+static const char* tempo_labels[] = { "80", "100", "120", "130", "150" };
+static int32_t tempo_values[] = { 80, 100, 120, 130, 150 };
+static const SelectorConfig tempo_config = {
+    .display_values = tempo_labels,
+    .values         = tempo_values,
+    .norm_factor    = 1,
+    .count          = 5,
+    .default_index  = 2   // "120"
+};
+
+static const char* shape_labels[] = { "tri", "t_s", "saw", "squ", "re1", "re2" };
+static int32_t shape_values[] = { WaveIndex::Tri, WaveIndex::TriSaw, WaveIndex::Saw, WaveIndex::Square, WaveIndex::RectWide, WaveIndex::RectNarrow };
+static const SelectorConfig shape_config = {
+    .display_values = shape_labels,
+    .values         = shape_values,
+    .norm_factor    = 1,
+    .count          = 6,
+    .default_index  = 0   // "tri"
+};
+
+static const char* range_labels[] = { "32'", "16'", "8'", "4'", "2'" };
+static int32_t range_values[] = { 32, 16, 8, 4, 2 };
+static const SelectorConfig range_config = {
+    .display_values = range_labels,
+    .values         = range_values,
+    .norm_factor    = 8,
+    .count          = 5,
+    .default_index  = 2   // "8'"
+};
+
+static const char* boost_labels[] = { "+0", "+1", "+2" };
+static int32_t boost_values[] = { 10, 15, 20 };
+static const SelectorConfig boost_config = {
+    .display_values = boost_labels,
+    .values         = boost_values,
+    .norm_factor    = 10,
+    .count          = 3,
+    .default_index  = 0   // "+0"
+};
+
+static const char* beats_labels[] = { "1/16", "1/8", "3/16", "1/4", "3/8", "1/2" };
+static int32_t beats_values[] = { 25, 50, 75, 100, 150, 200 };
+static const SelectorConfig beats_config = {
+    .display_values = beats_labels,
+    .values         = beats_values,
+    .norm_factor    = 100,
+    .count          = 6,
+    .default_index  = 1   // "1/8"
+};
+
+// ---------- WIDGETS ----------
+static Switch   arp_enabled   = Switch  ("en");
+static Selector arp_division  = Selector("div", division_config);
+static Selector arp_tempo     = Selector("bpm", tempo_config);
+static Selector osc1_range    = Selector("octv", range_config);
+static Knob     osc1_detune   = Knob    ("tune", detune_config);
+static Selector osc1_shape    = Selector("shp", shape_config);
+static Knob     osc1_pan      = Knob    ("pan", pan_config);
+static Knob     osc1_gain     = Knob    ("gain", level_config);
+static Switch   osc1_enabled  = Switch  ("en", true);
+static Selector osc2_range    = Selector("octv", range_config);
+static Knob     osc2_detune   = Knob    ("tune", detune_config);
+static Selector osc2_shape    = Selector("shp", shape_config);
+static Knob     osc2_pan      = Knob    ("pan", pan_config);
+static Knob     osc2_gain     = Knob    ("gain", level_config);
+static Switch   osc2_enabled  = Switch  ("en");
+static Selector osc3_range    = Selector("octv", range_config);
+static Knob     osc3_detune   = Knob    ("tune", detune_config);
+static Selector osc3_shape    = Selector("shp", shape_config);
+static Knob     osc3_pan      = Knob    ("pan", pan_config);
+static Knob     osc3_gain     = Knob    ("gain", level_config);
+static Switch   osc3_enabled  = Switch  ("en");
+static Knob     env_attack    = Knob    ("att", time_config);
+static Knob     env_decay     = Knob    ("dec", time_config);
+static Knob     env_sustain   = Knob    ("sus", level_config);
+static Selector env_boost     = Selector("bst", boost_config);
+static Knob     env_gain      = Knob    ("gain", level_config, 1.f);
+static Knob     flt_cutoff    = Knob    ("cut", cutoff_config);
+static Knob     flt_resonance = Knob    ("res", level_config, 0.3f);
+static Knob     flt_contour   = Knob    ("cou", contour_config);
+static Knob     flt_attack    = Knob    ("att", time_config);
+static Knob     flt_decay     = Knob    ("dec", time_config);
+static Knob     flt_sustain   = Knob    ("sus", level_config);
+static Knob     fx_delay      = Knob    ("dly", mix_config);
+static Knob     fx_feedback   = Knob    ("fb", level_config);
+static Selector fx_beats      = Selector("time", beats_config);
+static Knob     fx_chorus     = Knob    ("cho", mix_config);
+static Knob     fx_reverb     = Knob    ("rev", mix_config);
+static Knob     fx_size       = Knob    ("size", level_config);
+
+static Widget *const param_widgets[ParamIndex::Count] = {
+    &arp_enabled,
+    &arp_division,
+    &arp_tempo,
+    &osc1_range,
+    &osc1_detune,
+    &osc1_shape,
+    &osc1_pan,
+    &osc1_gain,
+    &osc1_enabled,
+    &osc2_range,
+    &osc2_detune,
+    &osc2_shape,
+    &osc2_pan,
+    &osc2_gain,
+    &osc2_enabled,
+    &osc3_range,
+    &osc3_detune,
+    &osc3_shape,
+    &osc3_pan,
+    &osc3_gain,
+    &osc3_enabled,
+    &env_attack,
+    &env_decay,
+    &env_sustain,
+    &env_boost,
+    &env_gain,
+    &flt_cutoff,
+    &flt_resonance,
+    &flt_contour,
+    &flt_attack,
+    &flt_decay,
+    &flt_sustain,
+    &fx_delay,
+    &fx_feedback,
+    &fx_beats,
+    &fx_chorus,
+    &fx_reverb,
+    &fx_size,
+};
@@ -0,0 +1,115 @@
+#pragma once
+// generated by generation/params.py, edit the schema there
+#include <cinttypes>
+
+namespace Tab {
+    enum Value {
+        Input,
+        Osc1,
+        Osc2,
+        Osc3,
+        Envelope,
+        Filter,
+        Effects,
+    };
+};
+
+constexpr const char* tab_names[] = {
+    "arp", "o1", "o2", "o3", "env", "flt", "fx"
+};
+
+const uint8_t TAB_COUNT = 7;
+
+/** dense parameter index, the position in every flat parameter array */
+namespace ParamIndex {
+    enum Value {
+        ArpEnabled,
+        ArpDivision,
+        ArpTempo,
+        Osc1Range,
+        Osc1Detune,
+        Osc1Shape,
+        Osc1Pan,
+        Osc1Gain,
+        Osc1Enabled,
+        Osc2Range,
+        Osc2Detune,
+        Osc2Shape,
+        Osc2Pan,
+        Osc2Gain,
+        Osc2Enabled,
+        Osc3Range,
+        Osc3Detune,
+        Osc3Shape,
+        Osc3Pan,
+        Osc3Gain,
+        Osc3Enabled,
+        EnvAttack,
+        EnvDecay,
+        EnvSustain,
+        EnvBoost,
+        EnvGain,
+        FltCutoff,
+        FltResonance,
+        FltContour,
+        FltAttack,
+        FltDecay,
+        FltSustain,
+        FxDelay,
+        FxFeedback,
+        FxBeats,
+        FxChorus,
+        FxReverb,
+        FxSize,
+        Count,
+    };
+};
+
+#define PARAM_CC_NONE 0xFF
+
+struct ParamSpec {
+    uint8_t tab;
+    uint8_t slot;
+    uint8_t cc;     // midi control change number, PARAM_CC_NONE when unmapped
+};
+
+constexpr ParamSpec PARAM_SPECS[ParamIndex::Count] = {
+    { 0, 0, PARAM_CC_NONE },        // ArpEnabled
+    { 0, 1, PARAM_CC_NONE },        // ArpDivision
+    { 0, 2, PARAM_CC_NONE },        // ArpTempo
+    { 1, 0, PARAM_CC_NONE },        // Osc1Range
+    { 1, 1, 80 },                   // Osc1Detune
+    { 1, 2, PARAM_CC_NONE },        // Osc1Shape
+    { 1, 3, PARAM_CC_NONE },        // Osc1Pan
+    { 1, 4, 16 },                   // Osc1Gain
+    { 1, 5, PARAM_CC_NONE },        // Osc1Enabled
+    { 2, 0, PARAM_CC_NONE },        // Osc2Range
+    { 2, 1, 81 },                   // Osc2Detune
+    { 2, 2, PARAM_CC_NONE },        // Osc2Shape
+    { 2, 3, PARAM_CC_NONE },        // Osc2Pan
+    { 2, 4, 17 },                   // Osc2Gain
+    { 2, 5, PARAM_CC_NONE },        // Osc2Enabled
+    { 3, 0, PARAM_CC_NONE },        // Osc3Range
+    { 3, 1, 82 },                   // Osc3Detune
+    { 3, 2, PARAM_CC_NONE },        // Osc3Shape
+    { 3, 3, PARAM_CC_NONE },        // Osc3Pan
+    { 3, 4, 18 },                   // Osc3Gain
+    { 3, 5, PARAM_CC_NONE },        // Osc3Enabled
+    { 4, 0, 73 },                   // EnvAttack
+    { 4, 1, 75 },                   // EnvDecay
+    { 4, 2, 70 },                   // EnvSustain
+    { 4, 4, PARAM_CC_NONE },        // EnvBoost
+    { 4, 5, 7 },                    // EnvGain
+    { 5, 0, 74 },                   // FltCutoff
+    { 5, 1, 71 },                   // FltResonance
+    { 5, 2, 76 },                   // FltContour
+    { 5, 3, PARAM_CC_NONE },        // FltAttack
+    { 5, 4, PARAM_CC_NONE },        // FltDecay
+    { 5, 5, PARAM_CC_NONE },        // FltSustain
+    { 6, 0, 94 },                   // FxDelay
+    { 6, 1, PARAM_CC_NONE },        // FxFeedback
+    { 6, 2, PARAM_CC_NONE },        // FxBeats
+    { 6, 3, 93 },                   // FxChorus
+    { 6, 4, 91 },                   // FxReverb
+    { 6, 5, 19 },                   // FxSize
+};
@@ -1 +1,28 @@
-#include "widget.hpp"
\ No newline at end of file
+#include "widget.hpp"
+#include <cstdio>
+
+void format_hz(char *buffer, size_t len, float value) {
+    if(value >= 1000.f) snprintf(buffer, len, "%.1fk", value / 1000.f);
+    else                snprintf(buffer, len, "%.0f", value);
+}
+
+void format_secs(char *buffer, size_t len, float value) {
+    if(value < 1.f)       snprintf(buffer, len, "%.2fs", value);
+    else if(value < 10.f) snprintf(buffer, len, "%.1fs", value);
+    else                  snprintf(buffer, len, "%.0fs", value);
+}
+
+void format_ratio(char *buffer, size_t len, float value) {
+    snprintf(buffer, len, "%.2f", value);
+}
+
+void format_cents(char *buffer, size_t len, float value) {
+    snprintf(buffer, len, "%+.0f", value);
+}
+
+void format_pan(char *buffer, size_t len, float value) {
+    const int perc = lroundf(value * 100);
+    if(perc < 0)      snprintf(buffer, len, "L%d", -perc);
+    else if(perc > 0) snprintf(buffer, len, "R%d", perc);
+    else              snprintf(buffer, len, "C");
+}
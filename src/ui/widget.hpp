@@ -1,22 +1,40 @@
 #pragma once
 #include <cinttypes>
 #include <cstddef>
-#include <Preferences.h>
 #include <Adafruit_SSD1306.h>
 #include <array>
 #include "input/events.hpp"
+#include "ui/display.hpp"
 
 
 struct Widget {
+    // box every parameter widget draws inside, cleared before a partial redraw
+    static constexpr int16_t WIDTH = 40;
+    static constexpr int16_t HEIGHT = 20;
+
     const char *key;
     int16_t x, y;
+    bool dirty = true;  // value changed since the last render
 
     virtual const char *get_key() { return key; }
     virtual void render(Adafruit_SSD1306 *gfx) {}
+
+    /** redraws the widget box only if dirty and adds it to region */
+    virtual void render_dirty(Adafruit_SSD1306 *gfx, DirtyRegion &region) {
+        if(!dirty) return;
+        gfx->fillRect(x, y, WIDTH, HEIGHT, SSD1306_BLACK);
+        render(gfx);
+        region.add(x, y, WIDTH, HEIGHT);
+        dirty = false;
+    }
+
     virtual void process_event(const InputEvent &event) {}
     // virtual void nudge(int16_t dir) {}
-    virtual void load(const Preferences &prefs) {}
-    virtual void store(const Preferences &prefs) {}
+
+    /** value as the parameter api sees it: switch 0/1, selector index, knob position. set clamps */
+    virtual int32_t get_raw() { return 0; }
+    virtual int32_t get_raw_max() { return 0; }
+    virtual void set_raw(int32_t raw) {}
 
     virtual ~Widget() = default;
 
@@ -26,18 +44,19 @@ protected:
 };
 
 
-// using SwitchCallback = void(*)(bool);
-using SwitchCallback = std::function<void(bool)>;
+// plain function pointers: std::function may allocate
+using SwitchCallback = void(*)(bool value, void *ctx);
 
 struct Switch : Widget {
     bool value = false;
     SwitchCallback cb = nullptr;
+    void *cb_ctx = nullptr;
 
     Switch(const char *key, int16_t x, int16_t y)
         : Widget(key, x, y) {}
 
-    Switch(const char *key)
-        : Widget(key, 0, 0) {}
+    Switch(const char *key, bool value = false)
+        : Widget(key, 0, 0), value(value) {}
 
     void nudge(int16_t dir) {
         if(dir == 0) return;
@@ -45,7 +64,8 @@ struct Switch : Widget {
 
         if (new_value != value) {
             value = new_value;
-            if(cb) cb(value);
+            dirty = true;
+            if(cb) cb(value, cb_ctx);
         }
     }
 
@@ -67,10 +87,13 @@ struct Switch : Widget {
     }
 
     bool get_value() { return value; }
+
+    virtual int32_t get_raw() override { return value; }
+    virtual int32_t get_raw_max() override { return 1; }
+    virtual void set_raw(int32_t raw) override { nudge(raw ? 1 : -1); }
 };
 
-// using SelectorCallback = void(*)(int32_t value);
-using SelectorCallback = std::function<void(int32_t)>;
+using SelectorCallback = void(*)(int32_t value, void *ctx);
 
 struct SelectorConfig
 {
@@ -85,6 +108,7 @@ struct Selector : Widget {
     int32_t index = 0;
     SelectorConfig config;
     SelectorCallback cb = nullptr;
+    void *cb_ctx = nullptr;
 
     Selector(const char *key, int16_t x, int16_t y, const SelectorConfig &config)
         : Widget(key, x, y), config(config) {
@@ -102,7 +126,8 @@ struct Selector : Widget {
 
         if (new_index != index) {
             index = new_index;
-            if(cb) cb(config.values[index]);
+            dirty = true;
+            if(cb) cb(config.values[index], cb_ctx);
         }
     }
 
@@ -125,11 +150,121 @@ struct Selector : Widget {
         gfx->fillRect(x+1, y + thumb_y, 2, 4,   SSD1306_WHITE);
     }
 
+    virtual int32_t get_raw() override { return index; }
+    virtual int32_t get_raw_max() override { return config.count - 1; }
+    virtual void set_raw(int32_t raw) override { nudge(constrain(raw, 0, (int32_t)config.count - 1) - index); }
+
     int32_t get_value() { return config.values[index]; }
     float   get_value_asf32() { return (float)(config.values[index]) / config.norm_factor; }
 };
 
 
+// ------- KNOB --------
+namespace Curve {
+    enum Value {
+        Linear,
+        Log,    // equal ratio per step, min and max must be > 0
+    };
+};
+
+using KnobFormat   = void(*)(char *buffer, size_t len, float value);
+using KnobCallback = void(*)(float value, void *ctx);
+
+void format_hz(char *buffer, size_t len, float value);
+void format_secs(char *buffer, size_t len, float value);
+void format_ratio(char *buffer, size_t len, float value);
+void format_cents(char *buffer, size_t len, float value);
+void format_pan(char *buffer, size_t len, float value);
+
+struct KnobConfig {
+    float        min;
+    float        max;
+    Curve::Value curve;
+    KnobFormat   format;
+    float        default_value;
+};
+
+/** continuous parameter: a 10 bit position mapped to [min, max] through a curve */
+struct Knob : Widget {
+    static constexpr int32_t RESOLUTION = 1024;
+    static constexpr int32_t DETENT_STEP = 4;   // positions per encoder step, acceleration multiplies it
+
+    int32_t pos = 0;
+    KnobConfig config;
+    KnobCallback cb = nullptr;
+    void *cb_ctx = nullptr;
+
+    Knob(const char *key, const KnobConfig &config)
+        : Widget(key, 0, 0), config(config) {
+            set_value(config.default_value);
+        }
+
+    /** same config, different starting value */
+    Knob(const char *key, const KnobConfig &config, float default_value)
+        : Widget(key, 0, 0), config(config) {
+            set_value(default_value);
+        }
+
+    void nudge(int16_t dir) {
+        if(dir == 0) return;
+        const int32_t new_pos = constrain(pos + dir * DETENT_STEP, 0, RESOLUTION - 1);
+
+        if (new_pos != pos) {
+            pos = new_pos;
+            dirty = true;
+            if(cb) cb(get_value(), cb_ctx);
+        }
+    }
+
+    virtual void process_event(const InputEvent &event) override {
+        nudge(event.value);
+    }
+
+    virtual void render(Adafruit_SSD1306 *gfx) override {
+        const int16_t x_text = x + 7;
+        gfx->setCursor(x_text, y);
+        gfx->print(key);
+
+        char text[8];
+        config.format(text, sizeof(text), get_value());
+        gfx->setCursor(x_text, y+12);
+        gfx->print(text);
+
+        const float perc = 1.f - (float)pos / (RESOLUTION - 1);
+        const int16_t thumb_y = roundf(perc * 14);
+
+        gfx->drawRect(x,   y,           4, 19,  SSD1306_WHITE);
+        gfx->fillRect(x+1, y + thumb_y, 2, 4,   SSD1306_WHITE);
+    }
+
+    virtual int32_t get_raw() override { return pos; }
+    virtual int32_t get_raw_max() override { return RESOLUTION - 1; }
+
+    virtual void set_raw(int32_t raw) override {
+        raw = constrain(raw, 0, RESOLUTION - 1);
+        if(raw == pos) return;
+        pos = raw;
+        dirty = true;
+        if(cb) cb(get_value(), cb_ctx);
+    }
+
+    float get_value() const {
+        const float t = (float)pos / (RESOLUTION - 1);
+        if(config.curve == Curve::Log) return config.min * powf(config.max / config.min, t);
+        return config.min + (config.max - config.min) * t;
+    }
+
+    void set_value(float value) {
+        value = constrain(value, config.min, config.max);
+        const float t = config.curve == Curve::Log
+            ? logf(value / config.min) / logf(config.max / config.min)
+            : (value - config.min) / (config.max - config.min);
+        pos = lroundf(t * (RESOLUTION - 1));
+        dirty = true;
+    }
+};
+
+
 struct WidgetGroup {
     static const size_t MAX_CHILDREN = 64;
 
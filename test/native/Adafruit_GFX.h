@@ -0,0 +1,64 @@
+#pragma once
+// host stand-in: a canvas with the drawing calls the ui makes. text uses the 6x8 cells of the built in
+// font, but the glyph pixels are made up: sizes and positions match the device, the shapes do not
+#include <cstdint>
+#include <cstddef>
+
+class Adafruit_GFX {
+public:
+    Adafruit_GFX(int16_t w, int16_t h) : _width(w), _height(h) {}
+    virtual ~Adafruit_GFX() = default;
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+        for(int16_t i = 0; i < w; i++) drawPixel(x + i, y, color);
+    }
+
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+        for(int16_t i = 0; i < h; i++) drawPixel(x, y + i, color);
+    }
+
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        for(int16_t i = 0; i < h; i++) drawFastHLine(x, y + i, w, color);
+    }
+
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        drawFastHLine(x, y, w, color);
+        drawFastHLine(x, y + h - 1, w, color);
+        drawFastVLine(x, y, h, color);
+        drawFastVLine(x + w - 1, y, h, color);
+    }
+
+    void setCursor(int16_t x, int16_t y) { cursor_x = x; cursor_y = y; }
+    void setTextColor(uint16_t color) { text_color = color; }
+    void setTextWrap(bool wrap) {}
+    void setTextSize(uint8_t size) {}
+
+    size_t print(const char *text) {
+        size_t n = 0;
+        for(; text[n]; n++) {
+            draw_char(cursor_x, cursor_y, text[n]);
+            cursor_x += 6;
+        }
+        return n;
+    }
+
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+
+protected:
+    int16_t _width, _height;
+    int16_t cursor_x = 0, cursor_y = 0;
+    uint16_t text_color = 1;
+
+    /** 5x7 inside the 6x8 cell, a fixed made up pattern per character */
+    void draw_char(int16_t x, int16_t y, char c) {
+        if(c == ' ') return;
+        for(int16_t col = 0; col < 5; col++) {
+            const uint8_t bits = (uint8_t)((uint8_t)c * 29 + col * 71 + ((uint8_t)c >> 3) * col) & 0x7F;
+            for(int16_t row = 0; row < 7; row++)
+                if(bits & (1 << row)) drawPixel(x + col, y + row, text_color);
+        }
+    }
+};
@@ -0,0 +1,43 @@
+#pragma once
+// host stand-in: the frame buffer in the panel page format, nothing is sent anywhere
+#include <cstring>
+#include "Adafruit_GFX.h"
+
+#define SSD1306_BLACK   0
+#define SSD1306_WHITE   1
+#define SSD1306_INVERSE 2
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_COLUMNADDR   0x21
+#define SSD1306_PAGEADDR     0x22
+
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+    Adafruit_SSD1306(uint8_t w, uint8_t h) : Adafruit_GFX(w, h), buffer(new uint8_t[w * h / 8]()) {}
+    ~Adafruit_SSD1306() { delete[] buffer; }
+
+    bool begin(uint8_t vcc = SSD1306_SWITCHCAPVCC, uint8_t addr = 0) { return true; }
+    void display() {}
+    void clearDisplay() { memset(buffer, 0, _width * _height / 8); }
+    uint8_t *getBuffer() { return buffer; }
+
+    bool getPixel(int16_t x, int16_t y) const {
+        if(x < 0 || y < 0 || x >= _width || y >= _height) return false;
+        return buffer[x + (y / 8) * _width] & (1 << (y & 7));
+    }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        if(x < 0 || y < 0 || x >= _width || y >= _height) return;
+        uint8_t &byte = buffer[x + (y / 8) * _width];
+        const uint8_t bit = 1 << (y & 7);
+
+        switch(color) {
+            case SSD1306_WHITE:   byte |= bit;  break;
+            case SSD1306_BLACK:   byte &= ~bit; break;
+            case SSD1306_INVERSE: byte ^= bit;  break;
+        }
+    }
+
+private:
+    uint8_t *buffer;
+};
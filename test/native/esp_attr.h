@@ -0,0 +1,8 @@
+#pragma once
+// host stand-in: no separate iram/dram, placement attributes expand to nothing
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_ATTR
+#define RTC_DATA_ATTR
+#define WORD_ALIGNED_ATTR
@@ -0,0 +1,9 @@
+#pragma once
+// host stand-in for the idf error codes
+#include <cstdint>
+
+typedef int esp_err_t;
+
+#define ESP_OK          0
+#define ESP_FAIL        -1
+#define ESP_ERR_TIMEOUT 0x107
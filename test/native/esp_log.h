@@ -0,0 +1,8 @@
+#pragma once
+// host stand-in: logs are dropped, the tests assert on behaviour instead
+
+#define ESP_LOGE(tag, format, ...) do { (void)(tag); } while(0)
+#define ESP_LOGW(tag, format, ...) do { (void)(tag); } while(0)
+#define ESP_LOGI(tag, format, ...) do { (void)(tag); } while(0)
+#define ESP_LOGD(tag, format, ...) do { (void)(tag); } while(0)
+#define ESP_LOGV(tag, format, ...) do { (void)(tag); } while(0)
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+#include <chrono>
+
+struct NativeTimer;
+typedef NativeTimer *esp_timer_handle_t;
+
+/** microseconds since the first call */
+inline int64_t esp_timer_get_time() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,34 @@
+#pragma once
+// host stand-in: the freertos types and calls the tested sources use, on top of std threads.
+// one tick is one millisecond
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+typedef uint32_t TickType_t;
+typedef int32_t  BaseType_t;
+typedef uint32_t UBaseType_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+
+#define portMAX_DELAY       0xFFFFFFFFu
+#define configTICK_RATE_HZ  1000
+#define portTICK_PERIOD_MS  (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)((uint64_t)(ms) * configTICK_RATE_HZ / 1000))
+
+namespace native_rtos {
+    /** waits until ready() with the lock held, false when the ticks ran out first */
+    template<typename Ready>
+    bool wait(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, TickType_t ticks, Ready ready) {
+        if(ticks == portMAX_DELAY) {
+            cv.wait(lock, ready);
+            return true;
+        }
+        return cv.wait_for(lock, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), ready);
+    }
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstring>
+#include "FreeRTOS.h"
+
+// copies items in and out of one buffer allocated at create, like the real queues
+struct NativeQueue {
+    std::mutex mutex;
+    std::condition_variable changed;
+    uint8_t *items;
+    size_t item_size;
+    size_t length;
+    size_t head = 0;
+    size_t count = 0;
+};
+
+typedef NativeQueue *QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    NativeQueue *queue = new NativeQueue();
+    queue->items = new uint8_t[length * item_size];
+    queue->item_size = item_size;
+    queue->length = length;
+    return queue;
+}
+
+inline void vQueueDelete(QueueHandle_t queue) {
+    delete[] queue->items;
+    delete queue;
+}
+
+inline BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if(!native_rtos::wait(queue->changed, lock, ticks, [queue] { return queue->count < queue->length; })) return pdFALSE;
+
+    memcpy(queue->items + (queue->head + queue->count) % queue->length * queue->item_size, item, queue->item_size);
+    queue->count++;
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return xQueueSendToBack(queue, item, ticks);
+}
+
+/** only for queues of length 1, like freertos */
+inline BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    memcpy(queue->items, item, queue->item_size);
+    queue->head = 0;
+    queue->count = 1;
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if(!native_rtos::wait(queue->changed, lock, ticks, [queue] { return queue->count > 0; })) return pdFALSE;
+
+    memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if(!native_rtos::wait(queue->changed, lock, ticks, [queue] { return queue->count > 0; })) return pdFALSE;
+
+    memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+    return pdTRUE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    return queue->count;
+}
+
+inline BaseType_t xQueueReset(QueueHandle_t queue) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    queue->head = 0;
+    queue->count = 0;
+    queue->changed.notify_all();
+    return pdPASS;
+}
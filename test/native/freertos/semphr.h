@@ -0,0 +1,37 @@
+#pragma once
+#include "FreeRTOS.h"
+
+struct NativeSemaphore {
+    std::mutex mutex;
+    std::condition_variable changed;
+    UBaseType_t count;
+};
+
+typedef NativeSemaphore *SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    NativeSemaphore *semaphore = new NativeSemaphore();
+    semaphore->count = 1;
+    return semaphore;
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary() {
+    NativeSemaphore *semaphore = new NativeSemaphore();
+    semaphore->count = 0;
+    return semaphore;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(semaphore->mutex);
+    if(!native_rtos::wait(semaphore->changed, lock, ticks, [semaphore] { return semaphore->count > 0; })) return pdFALSE;
+    semaphore->count--;
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    std::unique_lock<std::mutex> lock(semaphore->mutex);
+    if(semaphore->count > 0) return pdFALSE;
+    semaphore->count = 1;
+    semaphore->changed.notify_all();
+    return pdTRUE;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <thread>
+#include "FreeRTOS.h"
+
+// every thread is a task, notifications are a counter like xTaskNotifyGive / ulTaskNotifyTake use
+struct NativeTask {
+    std::mutex mutex;
+    std::condition_variable changed;
+    uint32_t notified = 0;
+};
+
+typedef NativeTask *TaskHandle_t;
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    static thread_local NativeTask self;
+    return &self;
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    std::unique_lock<std::mutex> lock(task->mutex);
+    task->notified++;
+    task->changed.notify_all();
+    return pdPASS;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(self->mutex);
+    if(!native_rtos::wait(self->changed, lock, ticks, [self] { return self->notified > 0; })) return 0;
+
+    const uint32_t value = self->notified;
+    self->notified = clear_on_exit ? 0 : value - 1;
+    return value;
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+}
+
+inline TickType_t xTaskGetTickCount() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() / portTICK_PERIOD_MS;
+}
@@ -0,0 +1,185 @@
+#include <unity.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "config.h"
+#include "audio/synth.hpp"
+#include "comms/ble_midi.hpp"
+#include "input/Btn.hpp"
+#include "input/accel.hpp"
+#include "memory/spsc_ring.hpp"
+#include "ui/UiController.hpp"
+#include "ui/frame.hpp"
+
+// the host version of ALLOC_GUARD: every heap call is counted, a test arms the counter
+// around the steady state and expects it to stay at zero. glibc only, like the native env
+static std::atomic<bool> s_armed{false};
+static std::atomic<size_t> s_allocs{0};
+
+static void count() {
+    if(s_armed) s_allocs++;
+}
+
+extern "C" {
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t n, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+
+    void *malloc(size_t size) { count(); return __libc_malloc(size); }
+    void *calloc(size_t n, size_t size) { count(); return __libc_calloc(n, size); }
+    void *realloc(void *ptr, size_t size) { count(); return __libc_realloc(ptr, size); }
+}
+
+void *operator new(size_t size) { count(); return __libc_malloc(size ? size : 1); }
+void *operator new[](size_t size) { count(); return __libc_malloc(size ? size : 1); }
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+/** runs body with the counter armed, returns how many allocations it made */
+template<typename F>
+static size_t allocations(F body) {
+    s_allocs = 0;
+    s_armed = true;
+    body();
+    s_armed = false;
+    return s_allocs;
+}
+
+
+// ------- FIXTURES --------
+static Synth synth;
+static Adafruit_SSD1306 display(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+static UiController ui(&display);
+static StereoSample block[SYNTH_CHUNK_SIZE];
+
+static MidiEvent note(bool on, uint8_t index) {
+    uint8_t raw[4] = { (uint8_t)(on ? 0x09 : 0x08), (uint8_t)(on ? 0x90 : 0x80), index, 100 };
+    return MidiEvent(raw);
+}
+
+
+// ------- CASES --------
+void setUp(void) {}
+void tearDown(void) {}
+
+/** the counter itself works, otherwise every zero below means nothing */
+void test_counter_sees_heap(void) {
+    TEST_ASSERT_EQUAL(1, allocations([] { int *volatile p = new int(1); delete p; }));
+    TEST_ASSERT_EQUAL(1, allocations([] { void *volatile p = malloc(16); free(p); }));
+}
+
+/** i2s_task after boot: scheduler, note events and blocks split where the events fall */
+void test_audio_path(void) {
+    // every voice section, effect and the morph get exercised once before the count
+    SynthConfig config = ui.config;
+    config.arpeggiator.enabled = true;
+    synth.update_config(config);
+    synth.process_midi_event(note(true, 60));
+    for(int i = 0; i < 50; i++) synth.process_block(block, SYNTH_CHUNK_SIZE);
+
+    static SpscRing<TimedMidiEvent, 64> uart_ring;
+    static SpscRing<TimedMidiEvent, 64> ble_ring;
+
+    const size_t count = allocations([] {
+        MidiScheduler scheduler;
+        TimedMidiEvent event;
+        uint32_t now_us = 0;
+        const uint32_t block_us = SYNTH_CHUNK_SIZE * 1000000ull / SYNTH_SR;
+
+        for(int i = 0; i < 400; i++) {
+            event.event = note(i & 1, 48 + i % 24);
+            event.time_us = now_us + (i * 997) % (2 * block_us);
+            (i % 3 ? uart_ring : ble_ring).push(event);
+
+            scheduler.collect(uart_ring, ble_ring);
+            synth.render_chunk(block, scheduler, now_us);
+            now_us += block_us;
+        }
+    });
+    TEST_ASSERT_EQUAL(0, count);
+}
+
+/** a config change reaches the audio task through the queue and the morph, also allocation free */
+void test_config_update(void) {
+    const size_t count = allocations([] {
+        SynthConfig config = ui.config;
+        for(int i = 0; i < 50; i++) {
+            config.lowpass.cutoff_hz = 500 + i * 20;
+            synth.update_config(config, (i & 1) ? 0.2f : 0.f);
+            synth.process_block(block, SYNTH_CHUNK_SIZE);
+        }
+    });
+    TEST_ASSERT_EQUAL(0, count);
+}
+
+/** midi in: ble packets decoded into the spsc ring the audio task pops from */
+void test_midi_in_path(void) {
+    static SpscRing<TimedMidiEvent, 64> ring;
+    static BleMidiDecoder decoder;
+    const uint8_t packet[] = { 0x80, 0x81, 0x90, 60, 100, 0x82, 0x80, 60, 0, 0x83, 0xB0, 74, 10 };
+
+    const size_t count = allocations([&] {
+        TimedMidiEvent event;
+        for(int i = 0; i < 200; i++) {
+            decoder.decode(packet, sizeof(packet), [&](const MidiEvent &midi, uint16_t timestamp_ms) {
+                TimedMidiEvent timed;
+                timed.event = midi;
+                timed.time_us = timestamp_ms * 1000u;
+                ring.push(timed);
+            });
+            while(ring.pop(&event)) synth.process_midi_event(event.event);
+        }
+    });
+    TEST_ASSERT_EQUAL(0, count);
+}
+
+/** display_task after boot: coalesced input, widget updates, sync, drawing and the frame diff */
+void test_input_path(void) {
+    static FrameManager frames;
+    QueueHandle_t queue = xQueueCreate(32, sizeof(InputEvent));
+    InputCoalescer coalescer;
+
+    const size_t count = allocations([&] {
+        for(int i = 0; i < 300; i++) {
+            InputEvent event;
+            event.id = (InputId)((int)InputId::Encoder0 + i % 3);
+            event.value = (i / 7) & 1 ? 1 : -1;
+            event.shifed = (i / 50) & 1;
+            event.timestamp_us = i * 5000;
+            xQueueSendToBack(queue, &event, 0);
+            xQueueSendToBack(queue, &event, 0);
+
+            if(i % 40 == 0) {
+                InputEvent tab;
+                tab.id = InputId::BtnRx;
+                tab.value = BtnEvent::Press;
+                xQueueSendToBack(queue, &tab, 0);
+            }
+
+            coalescer.drain(queue, [](const InputEvent &e) { ui.process_event(e); });
+            ui.control_change(74, i & 0x7F);
+            ui.sync();
+
+            DirtyRegion region;
+            if(ui.render_to_buffer(region)) frames.commit(display.getBuffer());
+        }
+    });
+    vQueueDelete(queue);
+    TEST_ASSERT_EQUAL(0, count);
+}
+
+int main(int argc, char **argv) {
+    // boot: everything allowed to allocate happens here
+    ui.init();
+    synth.begin();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_counter_sees_heap);
+    RUN_TEST(test_audio_path);
+    RUN_TEST(test_config_update);
+    RUN_TEST(test_midi_in_path);
+    RUN_TEST(test_input_path);
+    return UNITY_END();
+}
@@ -0,0 +1,118 @@
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "comms/uart_rx.hpp"
+
+// ------- REFERENCE --------
+// the bit by bit crc and frame check the decoder used before the table
+
+static void crc16_add_bitwise(uint16_t *crc, uint8_t x) {
+    *crc ^= x;
+    for(int j = 0; j < 8; j++) {
+        if(*crc & 1) *crc = (*crc >> 1) ^ 0x8408;
+        else         *crc >>= 1;
+    }
+}
+
+/** old PacketDecoder::verify_self: crc over everything but the last two bytes, compared against them */
+static bool verify_self_bitwise(const uint8_t *frame, size_t len) {
+    const uint16_t crc_true = (uint16_t)frame[len - 2] | ((uint16_t)frame[len - 1] << 8);
+    uint16_t crc = 0xFFFF;
+    for(size_t i = 0; i < len - 2; i++) crc16_add_bitwise(&crc, frame[i]);
+    return (uint16_t)~crc == crc_true;
+}
+
+/** what the decoder does now: one running crc over the whole frame, checked against the residue */
+static bool verify_residue(const uint8_t *frame, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for(size_t i = 0; i < len; i++) crc16_add(&crc, frame[i]);
+    return crc == CRC16_RESIDUE;
+}
+
+static std::vector<uint8_t> random_frame() {
+    std::vector<uint8_t> frame(2 + rand() % (PacketDecoder::MAX_PAYLOAD_LEN + 1));
+    for(auto &x : frame) x = rand();
+
+    uint16_t crc = 0xFFFF;
+    for(uint8_t x : frame) crc16_add_bitwise(&crc, x);
+    crc = ~crc;
+    frame.push_back(crc & 0xFF);
+    frame.push_back(crc >> 8);
+    return frame;
+}
+
+
+// ------- CASES --------
+void setUp(void) { srand(1); }
+void tearDown(void) {}
+
+void test_table_matches_bitwise(void) {
+    for(uint32_t start = 0; start <= 0xFFFF; start++) {
+        for(uint32_t x = 0; x <= 0xFF; x++) {
+            uint16_t table = start, bitwise = start;
+            crc16_add(&table, x);
+            crc16_add_bitwise(&bitwise, x);
+            if(table != bitwise) TEST_FAIL_MESSAGE("table and bitwise crc differ");
+        }
+    }
+}
+
+void test_check_value(void) {
+    const char *message = "123456789";
+    uint16_t crc = 0xFFFF;
+    for(const char *c = message; *c; c++) crc16_add(&crc, *c);
+
+    TEST_ASSERT_EQUAL_HEX16(0x906E, (uint16_t)~crc);
+}
+
+void test_residue_matches_verify_self(void) {
+    const size_t FRAMES = 100000;
+    size_t accepted = 0;
+
+    for(size_t i = 0; i < FRAMES; i++) {
+        std::vector<uint8_t> frame = random_frame();
+
+        // a third get one damaged byte, anywhere including the crc
+        if(i % 3 == 0) frame[rand() % frame.size()] ^= 1 + rand() % 255;
+
+        const bool expected = verify_self_bitwise(frame.data(), frame.size());
+        TEST_ASSERT_EQUAL(expected, verify_residue(frame.data(), frame.size()));
+        accepted += expected;
+    }
+
+    // all the clean frames and none of the corrupted ones
+    TEST_ASSERT_EQUAL(FRAMES - (FRAMES + 2) / 3, accepted);
+}
+
+void test_crc_throughput(void) {
+    std::vector<uint8_t> data(1 << 20);
+    for(auto &x : data) x = rand();
+
+    uint16_t table = 0xFFFF, bitwise = 0xFFFF;
+
+    auto start = std::chrono::steady_clock::now();
+    for(uint8_t x : data) crc16_add(&table, x);
+    const double table_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for(uint8_t x : data) crc16_add_bitwise(&bitwise, x);
+    const double bitwise_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    TEST_ASSERT_EQUAL_HEX16(bitwise, table);
+
+    char line[96];
+    snprintf(line, sizeof(line), "table: %.1f MB/s, bitwise: %.1f MB/s (x%.1f)",
+        data.size() / table_secs / 1e6, data.size() / bitwise_secs / 1e6, bitwise_secs / table_secs);
+    TEST_MESSAGE(line);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_table_matches_bitwise);
+    RUN_TEST(test_check_value);
+    RUN_TEST(test_residue_matches_verify_self);
+    RUN_TEST(test_crc_throughput);
+    return UNITY_END();
+}
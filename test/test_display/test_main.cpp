@@ -0,0 +1,211 @@
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "config.h"
+#include "ui/display.hpp"
+#include "ui/frame.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+/** panel stand-in: keeps what was written where, each window takes delay_ms like a slow i2c transfer */
+class MockBus : public DisplayBus {
+public:
+    uint8_t panel[SCREEN_BUFFER_SIZE] = {0};
+    std::atomic<uint32_t> writes{0};
+    std::atomic<uint32_t> page_writes[DISPLAY_PAGES];
+    std::atomic<uint32_t> delay_ms{0};
+    std::atomic<bool> bad_window{false};   // asserts can't run on the flush thread, checked in settle
+
+    MockBus() { for(auto &w : page_writes) w = 0; }
+
+    bool write_window(uint8_t page, uint8_t col_start, uint8_t col_end, const uint8_t *data) override {
+        if(page >= DISPLAY_PAGES || col_start > col_end || col_end >= DISPLAY_WIDTH) {
+            bad_window = true;
+            return false;
+        }
+        if(delay_ms) std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+
+        memcpy(panel + page * DISPLAY_WIDTH + col_start, data, col_end - col_start + 1);
+        page_writes[page]++;
+        writes++;
+        return true;
+    }
+};
+
+static MockBus bus;
+static uint8_t frame[SCREEN_BUFFER_SIZE];
+
+/** waits until the flush task left the bus alone for a while */
+static void settle() {
+    const uint32_t quiet_ms = 3 * bus.delay_ms + 20;
+    uint32_t seen = bus.writes;
+    auto since = Clock::now();
+    while(Clock::now() - since < std::chrono::milliseconds(quiet_ms)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        if(bus.writes != seen) {
+            seen = bus.writes;
+            since = Clock::now();
+        }
+    }
+    TEST_ASSERT_FALSE(bus.bad_window);
+}
+
+static void set_pixel(int16_t x, int16_t y, bool on) {
+    uint8_t &byte = frame[(y / 8) * DISPLAY_WIDTH + x];
+    byte = on ? byte | (1 << (y & 7)) : byte & ~(1 << (y & 7));
+}
+
+
+// ------- CASES --------
+void setUp(void) {
+    bus.delay_ms = 0;
+    settle();
+}
+
+void tearDown(void) {}
+
+/** the ui never waits for the bus: a submit costs a copy even while a slow flush is under way */
+void test_submit_does_not_wait_for_bus(void) {
+    bus.delay_ms = 10;
+    DirtyRegion all;
+    all.all();
+
+    memset(frame, 0x55, sizeof(frame));
+    oled::submit(frame, all);
+
+    Clock::duration worst = Clock::duration::zero();
+    for(int i = 0; i < 20; i++) {
+        frame[i] ^= 0xFF;
+        const auto start = Clock::now();
+        oled::submit(frame, all);
+        const auto spent = Clock::now() - start;
+        worst = spent > worst ? spent : worst;
+    }
+
+    // the first flush alone keeps the bus busy for 80 ms
+    TEST_ASSERT_TRUE(worst < std::chrono::milliseconds(5));
+    settle();
+    TEST_ASSERT_EQUAL_MEMORY(frame, bus.panel, sizeof(frame));
+}
+
+/** regions submitted while the bus is busy merge into one flush */
+void test_submits_coalesce(void) {
+    bus.delay_ms = 20;
+    const uint32_t before = bus.page_writes[3];
+
+    for(int i = 0; i < 30; i++) {
+        set_pixel(10 + i, 3 * 8 + (i & 7), true);
+        DirtyRegion region;
+        region.add(10 + i, 3 * 8, 1, 8);
+        oled::submit(frame, region);
+    }
+    settle();
+
+    // one flush can be in flight when the first submit lands, everything after it waits in one region
+    TEST_ASSERT_LESS_OR_EQUAL(2, bus.page_writes[3] - before);
+    TEST_ASSERT_EQUAL_MEMORY(frame, bus.panel, sizeof(frame));
+}
+
+/** random regions at random pace: whatever was coalesced, the panel ends up with the last frame */
+void test_final_content_matches(void) {
+    srand(7);
+    for(int i = 0; i < 300; i++) {
+        bus.delay_ms = rand() % 3;
+
+        DirtyRegion region;
+        const int16_t x = rand() % DISPLAY_WIDTH;
+        const int16_t y = rand() % DISPLAY_HEIGHT;
+        const int16_t w = 1 + rand() % 40;
+        const int16_t h = 1 + rand() % 20;
+        for(int16_t py = y; py < y + h && py < DISPLAY_HEIGHT; py++)
+            for(int16_t px = x; px < x + w && px < DISPLAY_WIDTH; px++)
+                set_pixel(px, py, rand() & 1);
+
+        region.add(x, y, w, h);
+        oled::submit(frame, region);
+        if(rand() % 4 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(rand() % 3));
+    }
+    settle();
+    TEST_ASSERT_EQUAL_MEMORY(frame, bus.panel, sizeof(frame));
+}
+
+/** an empty region is not a flush */
+void test_empty_region_skipped(void) {
+    const uint32_t before = bus.writes;
+    oled::submit(frame, DirtyRegion());
+    settle();
+    TEST_ASSERT_EQUAL(before, bus.writes);
+}
+
+void test_commit_unchanged_is_empty(void) {
+    FrameManager frames;
+    uint8_t back[SCREEN_BUFFER_SIZE] = {0};
+
+    TEST_ASSERT_TRUE(frames.commit(back).empty());
+}
+
+/** pages narrow down to the changed columns, the column range is shared by the pages */
+void test_commit_narrows_region(void) {
+    FrameManager frames;
+    uint8_t back[SCREEN_BUFFER_SIZE] = {0};
+
+    back[2 * DISPLAY_WIDTH + 40] = 1;
+    FrameDiff diff = frames.commit(back);
+    TEST_ASSERT_EQUAL_HEX8(1 << 2, diff.pages());
+    TEST_ASSERT_EQUAL(40, diff.region.col_start);
+    TEST_ASSERT_EQUAL(40, diff.region.col_end);
+
+    back[5 * DISPLAY_WIDTH + 90] = 1;
+    back[5 * DISPLAY_WIDTH + 100] = 1;
+    back[7 * DISPLAY_WIDTH + 20] = 1;
+    diff = frames.commit(back);
+    TEST_ASSERT_EQUAL_HEX8((1 << 5) | (1 << 7), diff.pages());
+    TEST_ASSERT_EQUAL(20, diff.region.col_start);
+    TEST_ASSERT_EQUAL(100, diff.region.col_end);
+    TEST_ASSERT_EQUAL_MEMORY(back, frames.front(), SCREEN_BUFFER_SIZE);
+
+    TEST_ASSERT_TRUE(frames.commit(back).empty());
+}
+
+/** the display task path: commit the back buffer, submit the diff, the panel follows the front buffer */
+void test_commit_then_submit(void) {
+    FrameManager frames;
+    frames.commit(bus.panel);
+
+    srand(11);
+    for(int i = 0; i < 100; i++) {
+        bus.delay_ms = rand() % 2;
+        frame[rand() % SCREEN_BUFFER_SIZE] ^= 1 << (rand() % 8);
+
+        const FrameDiff diff = frames.commit(frame);
+        oled::submit(frames.front(), diff.region);
+    }
+    settle();
+    TEST_ASSERT_EQUAL_MEMORY(frames.front(), bus.panel, sizeof(frame));
+}
+
+int main(int argc, char **argv) {
+    oled::begin(&bus);
+    std::thread(oled::flush_task, nullptr).detach();
+
+    // the task registers itself when it starts, submits before that only queue up
+    DirtyRegion all;
+    all.all();
+    while(bus.writes == 0) {
+        oled::submit(frame, all);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_submit_does_not_wait_for_bus);
+    RUN_TEST(test_submits_coalesce);
+    RUN_TEST(test_final_content_matches);
+    RUN_TEST(test_empty_region_skipped);
+    RUN_TEST(test_commit_unchanged_is_empty);
+    RUN_TEST(test_commit_narrows_region);
+    RUN_TEST(test_commit_then_submit);
+    return UNITY_END();
+}
@@ -0,0 +1,162 @@
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "config.h"
+#include "audio/effects.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// one arena for every effect: FxArena::begin always starts over on the same internal region
+static FxArena arena;
+static StereoDelay echo;
+static StereoChorus chorus;
+static LiteReverb reverb;
+static Effect *const effects[] = { &echo, &chorus, &reverb };
+
+static StereoSample block[SYNTH_CHUNK_SIZE];
+
+static void noise() {
+    for(auto &s : block) {
+        s.left  = rand() / (float)RAND_MAX - 0.5f;
+        s.right = rand() / (float)RAND_MAX - 0.5f;
+    }
+}
+
+static void silence() {
+    for(auto &s : block) s.left = s.right = 0.f;
+}
+
+static EffectsConfig with_mix(float mix) {
+    EffectsConfig config;
+    config.delay.mix = mix;
+    config.delay.beats = 0.25f;
+    config.chorus.mix = mix;
+    config.reverb.mix = mix;
+    return config;
+}
+
+/** plays noise through every effect so all lines hold something */
+static void fill_lines() {
+    for(auto effect : effects) effect->configure(with_mix(0.8f), 120.f);
+    for(int i = 0; i < 200; i++) {
+        noise();
+        for(auto effect : effects) effect->step(block, SYNTH_CHUNK_SIZE);
+    }
+}
+
+
+// ------- CASES --------
+void setUp(void) {}
+void tearDown(void) {}
+
+/** a disabled effect clears FX_CLEAR_FRAMES per block, never the whole line in one */
+void test_clear_is_sliced(void) {
+    fill_lines();
+    echo.configure(with_mix(0.f), 120.f);
+
+    const size_t line_frames = FX_DELAY_MAX_SECS * SYNTH_SR;
+    const int expected = (line_frames + FX_CLEAR_FRAMES - 1) / FX_CLEAR_FRAMES;
+    int blocks = 0;
+    do {
+        noise();
+        echo.step(block, SYNTH_CHUNK_SIZE);
+        blocks++;
+    } while(echo.clearing() && blocks < 1000);
+
+    TEST_ASSERT_GREATER_THAN(1, expected);
+    TEST_ASSERT_EQUAL(expected, blocks);
+}
+
+/** enabled again before the clear is done: silent until it is, then no echo of the old notes */
+void test_reenable_has_no_old_echoes(void) {
+    fill_lines();
+    for(auto effect : effects) effect->configure(with_mix(0.f), 120.f);
+    silence();
+    for(auto effect : effects) effect->step(block, SYNTH_CHUNK_SIZE);
+
+    for(auto effect : effects) effect->configure(with_mix(0.8f), 120.f);
+    for(int i = 0; i < 400; i++) {
+        silence();
+        for(auto effect : effects) effect->step(block, SYNTH_CHUNK_SIZE);
+        for(const auto &s : block) {
+            TEST_ASSERT_EQUAL_FLOAT(0.f, s.left);
+            TEST_ASSERT_EQUAL_FLOAT(0.f, s.right);
+        }
+    }
+    for(auto effect : effects) TEST_ASSERT_FALSE(effect->clearing());
+}
+
+/**
+ * average cost of a SYNTH_CHUNK_SIZE block against the budget the effect declares, and of a clear slice
+ * against the smallest budget. the host is faster than the esp32, FX_PROFILE measures on the device
+ */
+void test_block_cost_within_budget(void) {
+    const int blocks = 2000;
+    char line[96];
+
+    for(auto effect : effects) {
+        effect->configure(with_mix(0.8f), 120.f);
+        noise();
+
+        const auto start = Clock::now();
+        for(int i = 0; i < blocks; i++) effect->step(block, SYNTH_CHUNK_SIZE);
+        const double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / blocks;
+
+        snprintf(line, sizeof(line), "[%-6s] %.2fus per block (budget %uus)", effect->name, us, effect->budget_us);
+        TEST_MESSAGE(line);
+        TEST_ASSERT_TRUE(us <= effect->budget_us);
+    }
+
+    uint32_t smallest = UINT32_MAX;
+    for(auto effect : effects) smallest = effect->budget_us < smallest ? effect->budget_us : smallest;
+
+    double worst = 0.;
+    for(int round = 0; round < 20; round++) {
+        fill_lines();
+        echo.configure(with_mix(0.f), 120.f);
+        int slices = 0;
+
+        const auto start = Clock::now();
+        do {
+            echo.step(block, SYNTH_CHUNK_SIZE);
+            slices++;
+        } while(echo.clearing());
+        const double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / slices;
+        worst = us > worst ? us : worst;
+    }
+
+    snprintf(line, sizeof(line), "[clear ] %.2fus per slice", worst);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(worst <= smallest);
+}
+
+/** a morph through mix 0 keeps the effect on, it only turns off once released */
+void test_hold_keeps_enabled(void) {
+    fill_lines();
+
+    echo.hold(true);
+    echo.configure(with_mix(0.f), 120.f);
+    noise();
+    echo.step(block, SYNTH_CHUNK_SIZE);
+    TEST_ASSERT_TRUE(echo.enabled());
+    TEST_ASSERT_FALSE(echo.clearing());
+
+    echo.hold(false);
+    echo.configure(with_mix(0.f), 120.f);
+    echo.step(block, SYNTH_CHUNK_SIZE);
+    TEST_ASSERT_FALSE(echo.enabled());
+    TEST_ASSERT_TRUE(echo.clearing());
+}
+
+int main(int argc, char **argv) {
+    arena.begin();
+    for(auto effect : effects) effect->begin(arena);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_clear_is_sliced);
+    RUN_TEST(test_reenable_has_no_old_echoes);
+    RUN_TEST(test_block_cost_within_budget);
+    RUN_TEST(test_hold_keeps_enabled);
+    return UNITY_END();
+}
@@ -0,0 +1,221 @@
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "comms/uart_rx.hpp"
+
+using Bytes = std::vector<uint8_t>;
+
+// ------- ENCODER --------
+// what the sender does: header + payload + crc, 0x7D and 0x7E escaped, one delimiter at the end
+
+static void put_escaped(Bytes &out, uint8_t x) {
+    if(x == 0x7E)      { out.push_back(0x7D); out.push_back(0x53); }
+    else if(x == 0x7D) { out.push_back(0x7D); out.push_back(0x54); }
+    else               out.push_back(x);
+}
+
+/** body is the header (2 bytes) followed by the payload */
+static Bytes encode_frame(const Bytes &body) {
+    uint16_t crc = 0xFFFF;
+    for(uint8_t x : body) crc16_add(&crc, x);
+    crc = ~crc;
+
+    Bytes out;
+    for(uint8_t x : body) put_escaped(out, x);
+    put_escaped(out, crc & 0xFF);
+    put_escaped(out, crc >> 8);
+    out.push_back(0x7E);
+    return out;
+}
+
+static Bytes random_body(size_t payload_len) {
+    Bytes body(2 + payload_len);
+    // plenty of bytes that need escaping
+    for(auto &x : body) x = rand() % 4 == 0 ? 0x7D + rand() % 2 : rand();
+    return body;
+}
+
+/** feeds the whole stream and collects header + payload of every decoded packet */
+static std::vector<Bytes> decode_all(PacketDecoder &decoder, const Bytes &stream) {
+    std::vector<Bytes> packets;
+    Packet packet;
+
+    for(uint8_t x : stream) {
+        if(!decoder.decode(x, &packet)) continue;
+        Bytes body = { 0x00, packet.type };
+        body.insert(body.end(), packet.payload, packet.payload + packet.payload_len);
+        packets.push_back(body);
+    }
+    return packets;
+}
+
+/** the first header byte is not handed out, compare from the type on */
+static bool same_packet(const Bytes &sent, const Bytes &decoded) {
+    return sent.size() == decoded.size() && memcmp(sent.data() + 1, decoded.data() + 1, sent.size() - 1) == 0;
+}
+
+
+// ------- CASES --------
+void setUp(void) { srand(1); }
+void tearDown(void) {}
+
+void test_valid_frame(void) {
+    PacketDecoder decoder;
+    const Bytes body = { 0x00, 0xA0, 0x90, 0x3C, 0x7E, 0x7D };
+    const auto packets = decode_all(decoder, encode_frame(body));
+
+    TEST_ASSERT_EQUAL(1, packets.size());
+    TEST_ASSERT_TRUE(same_packet(body, packets[0]));
+}
+
+void test_full_payload(void) {
+    PacketDecoder decoder;
+    const Bytes body = random_body(PacketDecoder::MAX_PAYLOAD_LEN);
+    const auto packets = decode_all(decoder, encode_frame(body));
+
+    TEST_ASSERT_EQUAL(1, packets.size());
+    TEST_ASSERT_TRUE(same_packet(body, packets[0]));
+}
+
+void test_overlong_dropped(void) {
+    PacketDecoder decoder;
+    Bytes stream = encode_frame(random_body(PacketDecoder::MAX_PAYLOAD_LEN + 1));
+    const Bytes next = { 0x00, 0xA0, 0x01 };
+    const Bytes tail = encode_frame(next);
+    stream.insert(stream.end(), tail.begin(), tail.end());
+
+    const auto packets = decode_all(decoder, stream);
+    TEST_ASSERT_EQUAL(1, packets.size());
+    TEST_ASSERT_TRUE(same_packet(next, packets[0]));
+    TEST_ASSERT_EQUAL(1, decoder.errors().overflow);
+}
+
+void test_bad_escape_dropped(void) {
+    PacketDecoder decoder;
+    Bytes stream = encode_frame({ 0x00, 0xA0, 0x7E, 0x01 });
+    stream[3] = 0x55;   // 0x7D 0x53 becomes an escape of nothing known
+
+    TEST_ASSERT_EQUAL(0, decode_all(decoder, stream).size());
+    TEST_ASSERT_EQUAL(1, decoder.errors().bad_escape);
+}
+
+void test_dangling_escape_dropped(void) {
+    PacketDecoder decoder;
+    // the crc checks out, only the 0x7D before the delimiter is wrong
+    Bytes stream = encode_frame({ 0x00, 0xA0, 0x01, 0x02 });
+    stream.insert(stream.end() - 1, 0x7D);
+
+    TEST_ASSERT_EQUAL(0, decode_all(decoder, stream).size());
+    TEST_ASSERT_EQUAL(1, decoder.errors().bad_escape);
+
+    // and the decoder starts clean after it
+    const Bytes next = { 0x00, 0xA0, 0x03 };
+    const auto packets = decode_all(decoder, encode_frame(next));
+    TEST_ASSERT_EQUAL(1, packets.size());
+    TEST_ASSERT_TRUE(same_packet(next, packets[0]));
+}
+
+void test_corrupted_dropped(void) {
+    PacketDecoder decoder;
+    Bytes stream = encode_frame({ 0x00, 0xA0, 0x01, 0x02, 0x03 });
+    stream[3] ^= 0x10;
+
+    TEST_ASSERT_EQUAL(0, decode_all(decoder, stream).size());
+    TEST_ASSERT_EQUAL(1, decoder.errors().crc);
+}
+
+/**
+ * a long stream of valid frames mixed with every kind of broken one: all the valid frames
+ * come out in order and nothing else does
+ */
+void test_fuzz_random_frames(void) {
+    enum { Valid, Overlong, Corrupted, BadEscape, DanglingEscape, Garbage, KINDS };
+    const size_t FRAMES = 50000;
+
+    Bytes stream = { 0x7E };
+    std::vector<Bytes> expected;
+    size_t broken[KINDS] = { 0 };
+
+    for(size_t i = 0; i < FRAMES; i++) {
+        const int kind = rand() % 3 ? Valid : 1 + rand() % (KINDS - 1);
+        broken[kind]++;
+
+        if(kind == Garbage) {
+            for(int k = rand() % 8; k >= 0; k--) stream.push_back(rand());
+            stream.push_back(0x7E);
+            continue;
+        }
+
+        const size_t len = kind == Overlong
+            ? PacketDecoder::MAX_PAYLOAD_LEN + 1 + rand() % 64
+            : rand() % (PacketDecoder::MAX_PAYLOAD_LEN + 1);
+        const Bytes body = random_body(len);
+        Bytes frame = encode_frame(body);
+
+        switch(kind) {
+            case Valid:          expected.push_back(body); break;
+            case Corrupted:      frame[rand() % (frame.size() - 1)] ^= 1 + rand() % 255; break;
+            case DanglingEscape: frame.insert(frame.end() - 1, 0x7D); break;
+            case BadEscape: {
+                const size_t at = rand() % (frame.size() - 1);
+                frame.insert(frame.begin() + at, { 0x7D, (uint8_t)(rand() % 0x53) });
+                break;
+            }
+        }
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    PacketDecoder decoder;
+    const auto packets = decode_all(decoder, stream);
+
+    TEST_ASSERT_EQUAL(expected.size(), packets.size());
+    for(size_t i = 0; i < packets.size(); i++)
+        TEST_ASSERT_TRUE_MESSAGE(same_packet(expected[i], packets[i]), "decoded packet differs from the sent one");
+
+    char line[128];
+    snprintf(line, sizeof(line), "%zu valid, %zu overlong, %zu corrupted, %zu bad escape, %zu dangling, %zu garbage",
+        broken[Valid], broken[Overlong], broken[Corrupted], broken[BadEscape], broken[DanglingEscape], broken[Garbage]);
+    TEST_MESSAGE(line);
+}
+
+void test_decode_throughput(void) {
+    const size_t ROUNDS = 20;
+
+    Bytes stream;
+    while(stream.size() < 1 << 20) {
+        const Bytes frame = encode_frame(random_body(rand() % (PacketDecoder::MAX_PAYLOAD_LEN + 1)));
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    PacketDecoder decoder;
+    Packet packet;
+    size_t decoded = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for(size_t r = 0; r < ROUNDS; r++) {
+        for(uint8_t x : stream) decoded += decoder.decode(x, &packet);
+    }
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    TEST_ASSERT_GREATER_THAN(0, decoded);
+
+    char line[96];
+    snprintf(line, sizeof(line), "decode: %.1f MB/s, %.0f packets/s", ROUNDS * stream.size() / secs / 1e6, decoded / secs);
+    TEST_MESSAGE(line);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_valid_frame);
+    RUN_TEST(test_full_payload);
+    RUN_TEST(test_overlong_dropped);
+    RUN_TEST(test_bad_escape_dropped);
+    RUN_TEST(test_dangling_escape_dropped);
+    RUN_TEST(test_corrupted_dropped);
+    RUN_TEST(test_fuzz_random_frames);
+    RUN_TEST(test_decode_throughput);
+    return UNITY_END();
+}
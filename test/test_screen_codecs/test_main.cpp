@@ -0,0 +1,161 @@
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "config.h"
+#include "input/Btn.hpp"
+#include "ui/UiController.hpp"
+#include "remote/compress.hpp"
+#include "remote/screen_stream.hpp"
+
+// same split and codec set as remote.cpp.
+// the stand-in font has made up glyph shapes: the glyph_lz ratios below do not carry over to the device
+#define BLOCK_SIZE 256
+#define BLOCK_NUM  (SCREEN_BUFFER_SIZE / BLOCK_SIZE)
+#define STREAM_CODECS (SCREEN_CODEC_BIT(ScreenCodec::Rle) | SCREEN_CODEC_BIT(ScreenCodec::PackBits))
+
+using Frame = std::vector<uint8_t>;
+
+static Adafruit_SSD1306 display(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+static UiController ui(&display);
+static uint8_t glyphs[GLYPH_DICT_SIZE];
+static std::vector<Frame> frames;
+
+
+// ------- CAPTURE --------
+static void input(InputId id, int16_t value, bool shifted = false) {
+    InputEvent event;
+    event.id = id;
+    event.value = value;
+    event.shifed = shifted;
+    ui.process_event(event);
+
+    DirtyRegion region;
+    if(ui.render_to_buffer(region))
+        frames.push_back(Frame(display.getBuffer(), display.getBuffer() + SCREEN_BUFFER_SIZE));
+}
+
+/**
+ * what render_to_buffer draws during a session: every tab, each encoder swept up and back on both layers.
+ * the glyphs are the stand-in font, so sizes are close to the device but not the same
+ */
+static void capture_session() {
+    ui.render_glyphs(glyphs, sizeof(glyphs));
+    set_glyph_dictionary(glyphs, sizeof(glyphs));
+
+    ui.init();
+    input(InputId::None, 0);
+
+    for(uint8_t tab = 0; tab < TAB_COUNT; tab++) {
+        for(int layer = 0; layer < 2; layer++) {
+            if(layer) input(InputId::BtnShift, BtnEvent::Press);
+
+            for(int e = 0; e < 3; e++) {
+                const InputId encoder = (InputId)((int)InputId::Encoder0 + e);
+                for(int step = 0; step < 12; step++) input(encoder, step < 8 ? 1 : -1, layer);
+            }
+
+            if(layer) input(InputId::BtnShift, BtnEvent::Release);
+        }
+        input(InputId::BtnRx, BtnEvent::Press);
+    }
+}
+
+
+// ------- CASES --------
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_session_captured(void) {
+    TEST_ASSERT_GREATER_THAN(300, frames.size());
+
+    char line[64];
+    snprintf(line, sizeof(line), "%zu frames captured", frames.size());
+    TEST_MESSAGE(line);
+}
+
+/** every codec on every changed block, as keyframe (the block) and as patch (xor with the previous frame) */
+void test_codecs_roundtrip_and_bench(void) {
+    static uint8_t patch[BLOCK_SIZE];
+    static uint8_t out[BLOCK_SIZE * 2];
+    static uint8_t back[BLOCK_SIZE];
+
+    size_t bytes[CODEC_COUNT][2] = {{0}};
+    double secs[CODEC_COUNT][2] = {{0}};
+    size_t blocks = 0;
+
+    for(size_t f = 1; f < frames.size(); f++) {
+        for(size_t b = 0; b < BLOCK_NUM; b++) {
+            const uint8_t *block = frames[f].data() + b * BLOCK_SIZE;
+            const uint8_t *previous = frames[f - 1].data() + b * BLOCK_SIZE;
+            if(memcmp(block, previous, BLOCK_SIZE) == 0) continue;
+
+            for(size_t k = 0; k < BLOCK_SIZE; k++) patch[k] = block[k] ^ previous[k];
+            const uint8_t *inputs[2] = { block, patch };
+            blocks++;
+
+            for(size_t c = 0; c < CODEC_COUNT; c++) {
+                for(size_t m = 0; m < 2; m++) {
+                    const auto start = std::chrono::steady_clock::now();
+                    const size_t len = CODECS[c].encode(inputs[m], BLOCK_SIZE, out, sizeof(out));
+                    secs[c][m] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                    // a failed encode costs the rle worst case, like the device bench
+                    bytes[c][m] += len ? len : BLOCK_SIZE * 2;
+                    if(!len) continue;
+
+                    TEST_ASSERT_EQUAL(BLOCK_SIZE, CODECS[c].decode(out, len, back, sizeof(back)));
+                    TEST_ASSERT_EQUAL_MEMORY(inputs[m], back, BLOCK_SIZE);
+                }
+            }
+        }
+    }
+
+    TEST_ASSERT_GREATER_THAN(0, blocks);
+
+    char line[128];
+    snprintf(line, sizeof(line), "%zu changed blocks of %d bytes", blocks, BLOCK_SIZE);
+    TEST_MESSAGE(line);
+    for(size_t c = 0; c < CODEC_COUNT; c++) {
+        snprintf(line, sizeof(line), "[%-8s] key x%.3f %.2fus, patch x%.3f %.2fus", CODECS[c].name,
+            (double)bytes[c][0] / (blocks * BLOCK_SIZE), secs[c][0] * 1e6 / blocks,
+            (double)bytes[c][1] / (blocks * BLOCK_SIZE), secs[c][1] * 1e6 / blocks);
+        TEST_MESSAGE(line);
+    }
+}
+
+/** the session through the stream with the codecs the device uses, total bytes against raw frames */
+void test_stream_session(void) {
+    static ScreenEncoder<BLOCK_SIZE> encoders[BLOCK_NUM];
+    static ScreenDecoder<BLOCK_SIZE> decoders[BLOCK_NUM];
+    static uint8_t message[SCREEN_STREAM_MAX_LEN(BLOCK_SIZE)];
+    size_t sent = 0;
+
+    for(size_t f = 0; f < frames.size(); f++) {
+        for(size_t b = 0; b < BLOCK_NUM; b++) {
+            const uint8_t *block = frames[f].data() + b * BLOCK_SIZE;
+            if(f > 0 && memcmp(block, frames[f - 1].data() + b * BLOCK_SIZE, BLOCK_SIZE) == 0) continue;
+
+            const size_t len = encoders[b].encode(block, message, 32, STREAM_CODECS);
+            TEST_ASSERT_TRUE(decoders[b].decode(message, len));
+            TEST_ASSERT_EQUAL_MEMORY(block, decoders[b].block, BLOCK_SIZE);
+            sent += len;
+        }
+    }
+
+    char line[96];
+    snprintf(line, sizeof(line), "stream: %zu bytes for %zu frames, %.1f per frame (raw %d)",
+        sent, frames.size(), (double)sent / frames.size(), SCREEN_BUFFER_SIZE);
+    TEST_MESSAGE(line);
+}
+
+int main(int argc, char **argv) {
+    capture_session();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_session_captured);
+    RUN_TEST(test_codecs_roundtrip_and_bench);
+    RUN_TEST(test_stream_session);
+    return UNITY_END();
+}
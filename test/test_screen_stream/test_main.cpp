@@ -0,0 +1,250 @@
+#include <unity.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "config.h"
+#include "remote/screen_stream.hpp"
+
+// same split as remote.cpp
+#define BLOCK_SIZE 256
+#define BLOCK_NUM  (SCREEN_BUFFER_SIZE / BLOCK_SIZE)
+#define KEYFRAME_INTERVAL 32
+#define CODECS_USED (SCREEN_CODEC_BIT(ScreenCodec::Rle) | SCREEN_CODEC_BIT(ScreenCodec::PackBits) | SCREEN_CODEC_BIT(ScreenCodec::Lz))
+
+static uint8_t message[SCREEN_STREAM_MAX_LEN(BLOCK_SIZE)];
+
+/** what a value change looks like: a short run of columns redrawn somewhere in the buffer */
+static void edit(uint8_t *buffer, size_t len) {
+    const size_t at = rand() % (len - 24);
+    const size_t n = 4 + rand() % 20;
+    for(size_t i = 0; i < n; i++) buffer[at + i] = rand() % 3 ? rand() : 0;
+}
+
+
+// ------- NOTIFICATIONS --------
+/** the sending side of remote.cpp over a link that can lose notifications */
+struct Packer {
+    ScreenPacker<BLE_MAX_MTU> packer;
+    size_t capacity;
+    ScreenStreamDecoder<BLOCK_SIZE, BLOCK_NUM> *decoder;
+    bool drop_next = false;     // the link loses the next notification
+    bool all_ok = true;
+
+    void deliver(const uint8_t *packet, size_t len) {
+        if(!drop_next) all_ok &= decoder->decode(packet, len);
+        drop_next = false;
+    }
+
+    void flush() {
+        packer.flush([this](const uint8_t *packet, size_t len) { deliver(packet, len); });
+    }
+
+    void pack(uint8_t block, const uint8_t *msg, size_t msg_len) {
+        packer.pack(block, msg, msg_len, capacity, [this](const uint8_t *packet, size_t len) { deliver(packet, len); });
+    }
+};
+
+
+// ------- CASES --------
+void setUp(void) { srand(1); }
+void tearDown(void) {}
+
+void test_keyframe_then_patches(void) {
+    ScreenEncoder<BLOCK_SIZE> encoder;
+    ScreenDecoder<BLOCK_SIZE> decoder;
+    uint8_t block[BLOCK_SIZE] = {0};
+    size_t keyframes = 0, patches = 0;
+
+    for(int frame = 0; frame < 300; frame++) {
+        edit(block, sizeof(block));
+        const size_t len = encoder.encode(block, message, KEYFRAME_INTERVAL, CODECS_USED);
+
+        const uint8_t type = ((const ScreenHeader*)message)[0].type;
+        keyframes += type == ScreenMsg::Keyframe;
+        patches   += type == ScreenMsg::Patch;
+
+        TEST_ASSERT_TRUE(decoder.decode(message, len));
+        TEST_ASSERT_EQUAL_MEMORY(block, decoder.block, BLOCK_SIZE);
+    }
+
+    // the first message, then at least one every interval, and the seq wrapped along the way
+    TEST_ASSERT_EQUAL(((const ScreenHeader*)message)->type, ScreenMsg::Patch);
+    TEST_ASSERT_GREATER_OR_EQUAL(300 / KEYFRAME_INTERVAL, keyframes);
+    TEST_ASSERT_GREATER_THAN(keyframes, patches);
+}
+
+void test_patch_smaller_than_keyframe(void) {
+    ScreenEncoder<BLOCK_SIZE> encoder;
+    uint8_t block[BLOCK_SIZE];
+    for(auto &x : block) x = rand();
+
+    const size_t keyframe_len = encoder.encode(block, message, KEYFRAME_INTERVAL, CODECS_USED);
+    block[100] ^= 0xFF;
+    block[101] ^= 0x0F;
+    const size_t patch_len = encoder.encode(block, message, KEYFRAME_INTERVAL, CODECS_USED);
+
+    TEST_ASSERT_EQUAL(ScreenMsg::Patch, ((const ScreenHeader*)message)->type);
+    TEST_ASSERT_LESS_THAN(keyframe_len / 8, patch_len);
+
+    char line[96];
+    snprintf(line, sizeof(line), "keyframe %zu bytes, two byte patch %zu bytes", keyframe_len, patch_len);
+    TEST_MESSAGE(line);
+}
+
+/** a lost message drops the patches after it, the next keyframe brings the block back */
+void test_loss_recovery(void) {
+    ScreenEncoder<BLOCK_SIZE> encoder;
+    ScreenDecoder<BLOCK_SIZE> decoder;
+    uint8_t block[BLOCK_SIZE] = {0};
+
+    for(int lost = 0; lost < 20; lost++) {
+        // in sync before the loss
+        edit(block, sizeof(block));
+        TEST_ASSERT_TRUE(decoder.decode(message, encoder.encode(block, message, KEYFRAME_INTERVAL, CODECS_USED)));
+
+        edit(block, sizeof(block));
+        encoder.encode(block, message, KEYFRAME_INTERVAL, CODECS_USED);    // never arrives
+
+        int messages = 0;
+        bool recovered = false;
+        while(!recovered) {
+            edit(block, sizeof(block));
+            const size_t len = encoder.encode(block, message, KEYFRAME_INTERVAL, CODECS_USED);
+            const bool keyframe = ((const ScreenHeader*)message)->type == ScreenMsg::Keyframe;
+
+            TEST_ASSERT_EQUAL(keyframe, decoder.decode(message, len));
+            recovered = keyframe;
+            messages++;
+        }
+
+        TEST_ASSERT_LESS_OR_EQUAL(KEYFRAME_INTERVAL, messages);
+        TEST_ASSERT_EQUAL_MEMORY(block, decoder.block, BLOCK_SIZE);
+    }
+}
+
+/** a keyframe request (force_keyframe) resyncs at once */
+void test_forced_keyframe(void) {
+    ScreenEncoder<BLOCK_SIZE> encoder;
+    ScreenDecoder<BLOCK_SIZE> decoder;
+    uint8_t block[BLOCK_SIZE];
+    for(auto &x : block) x = rand();
+
+    encoder.encode(block, message, KEYFRAME_INTERVAL, CODECS_USED);    // lost
+    edit(block, sizeof(block));
+    TEST_ASSERT_FALSE(decoder.decode(message, encoder.encode(block, message, KEYFRAME_INTERVAL, CODECS_USED)));
+
+    encoder.force_keyframe = true;
+    edit(block, sizeof(block));
+    TEST_ASSERT_TRUE(decoder.decode(message, encoder.encode(block, message, KEYFRAME_INTERVAL, CODECS_USED)));
+    TEST_ASSERT_EQUAL_MEMORY(block, decoder.block, BLOCK_SIZE);
+}
+
+/** the whole screen through notifications at the smallest, a middle and the largest mtu */
+void test_stream_every_mtu(void) {
+    const size_t capacities[] = { 20, 182, BLE_MAX_MTU - 3 };
+
+    for(size_t capacity : capacities) {
+        static ScreenEncoder<BLOCK_SIZE> encoders[BLOCK_NUM];
+        static ScreenStreamDecoder<BLOCK_SIZE, BLOCK_NUM> decoder;
+        decoder = ScreenStreamDecoder<BLOCK_SIZE, BLOCK_NUM>();
+        for(auto &e : encoders) e = ScreenEncoder<BLOCK_SIZE>();
+
+        uint8_t screen[SCREEN_BUFFER_SIZE] = {0};
+        Packer packer;
+        packer.capacity = capacity;
+        packer.decoder = &decoder;
+
+        for(int frame = 0; frame < 200; frame++) {
+            for(int k = 0; k < 3; k++) edit(screen, sizeof(screen));
+            for(uint8_t b = 0; b < BLOCK_NUM; b++)
+                packer.pack(b, message, encoders[b].encode(screen + b * BLOCK_SIZE, message, KEYFRAME_INTERVAL, CODECS_USED));
+            packer.flush();
+
+            for(uint8_t b = 0; b < BLOCK_NUM; b++)
+                TEST_ASSERT_EQUAL_MEMORY(screen + b * BLOCK_SIZE, decoder.blocks[b].block, BLOCK_SIZE);
+        }
+        TEST_ASSERT_TRUE(packer.all_ok);
+    }
+}
+
+/**
+ * lost notifications, split messages included. a block may show an older frame until the loss is noticed,
+ * but never pixels that were not sent, and it is current again within a keyframe interval of the last loss
+ */
+void test_stream_lost_notifications(void) {
+    static ScreenEncoder<BLOCK_SIZE> encoders[BLOCK_NUM];
+    static ScreenStreamDecoder<BLOCK_SIZE, BLOCK_NUM> decoder;
+    static const int HISTORY = KEYFRAME_INTERVAL + 2;
+    static uint8_t history[HISTORY][SCREEN_BUFFER_SIZE];
+
+    uint8_t screen[SCREEN_BUFFER_SIZE] = {0};
+    Packer packer;
+    packer.capacity = 20;
+    packer.decoder = &decoder;
+    int last_loss = 0;
+    size_t losses = 0;
+
+    for(int frame = 0; frame < 5000; frame++) {
+        for(int k = 0; k < 3; k++) edit(screen, sizeof(screen));
+        memcpy(history[frame % HISTORY], screen, sizeof(screen));
+
+        for(uint8_t b = 0; b < BLOCK_NUM; b++) {
+            packer.pack(b, message, encoders[b].encode(screen + b * BLOCK_SIZE, message, KEYFRAME_INTERVAL, CODECS_USED));
+            if(rand() % 200 == 0) {
+                packer.drop_next = true;
+                last_loss = frame;
+                losses++;
+            }
+        }
+        packer.flush();
+
+        for(uint8_t b = 0; b < BLOCK_NUM; b++) {
+            const uint8_t *shown = decoder.blocks[b].block;
+
+            if(memcmp(shown, screen + b * BLOCK_SIZE, BLOCK_SIZE) == 0) continue;
+
+            TEST_ASSERT_LESS_OR_EQUAL(KEYFRAME_INTERVAL + 1, frame - last_loss);
+            if(!decoder.blocks[b].synced) continue;
+
+            bool sent_before = false;
+            for(int h = 0; h < HISTORY && h <= frame; h++)
+                sent_before |= memcmp(shown, history[h] + b * BLOCK_SIZE, BLOCK_SIZE) == 0;
+            TEST_ASSERT_TRUE_MESSAGE(sent_before, "a synced block shows pixels that were never sent");
+        }
+    }
+
+    TEST_ASSERT_FALSE(packer.all_ok);
+    TEST_ASSERT_GREATER_THAN(50, losses);
+}
+
+void test_malformed_input(void) {
+    ScreenStreamDecoder<BLOCK_SIZE, BLOCK_NUM> decoder;
+    uint8_t packet[64];
+
+    for(int i = 0; i < 10000; i++) {
+        const size_t len = rand() % sizeof(packet);
+        for(size_t k = 0; k < len; k++) packet[k] = rand();
+        decoder.decode(packet, len);    // must not crash or write out of bounds
+    }
+
+    // a segment longer than the packet
+    const uint8_t truncated[] = { 0, 0 | SCREEN_SEGMENT_FLAGS, 10, 0, ScreenMsg::Keyframe, 0, ScreenCodec::Rle };
+    TEST_ASSERT_FALSE(decoder.decode(truncated, sizeof(truncated)));
+
+    // a keyframe that decodes to the wrong size
+    const uint8_t short_block[] = { 1, 1 | SCREEN_SEGMENT_FLAGS, 5, 0, ScreenMsg::Keyframe, 0, ScreenCodec::Rle, 0x00, 0x10 };
+    TEST_ASSERT_FALSE(decoder.decode(short_block, sizeof(short_block)));
+    TEST_ASSERT_FALSE(decoder.blocks[1].synced);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_keyframe_then_patches);
+    RUN_TEST(test_patch_smaller_than_keyframe);
+    RUN_TEST(test_loss_recovery);
+    RUN_TEST(test_forced_keyframe);
+    RUN_TEST(test_stream_every_mtu);
+    RUN_TEST(test_stream_lost_notifications);
+    RUN_TEST(test_malformed_input);
+    return UNITY_END();
+}
@@ -0,0 +1,112 @@
+#include <unity.h>
+#include <thread>
+#include "config.h"
+#include "audio/midi.hpp"
+#include "memory/spsc_ring.hpp"
+
+using MidiRing = SpscRing<TimedMidiEvent, MIDI_EVENTS_QUEUE_SIZE>;
+
+/** every field derived from the sequence number, a torn or reordered item shows up as a mismatch */
+static TimedMidiEvent make_event(uint32_t seq, uint8_t source) {
+    TimedMidiEvent e;
+    e.event.header = source;
+    e.event.status = seq & 0xFF;
+    e.event.data1  = (seq >> 8) & 0xFF;
+    e.event.data2  = (seq >> 16) & 0xFF;
+    e.time_us = ~seq;
+    return e;
+}
+
+static bool check_event(const TimedMidiEvent &e, uint32_t seq, uint8_t source) {
+    const TimedMidiEvent expected = make_event(seq, source);
+    return e.event.header == expected.event.header && e.event.status == expected.event.status
+        && e.event.data1 == expected.event.data1 && e.event.data2 == expected.event.data2
+        && e.time_us == expected.time_us;
+}
+
+/** the producer side of rx_task or the ble callback: waits (yields) while the ring is full */
+static void produce(MidiRing *ring, uint32_t count, uint8_t source) {
+    for(uint32_t seq = 0; seq < count; ) {
+        if(ring->push(make_event(seq, source))) seq++;
+        else std::this_thread::yield();
+    }
+}
+
+
+// ------- CASES --------
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_fill_and_drain(void) {
+    static MidiRing ring;
+    TimedMidiEvent e;
+
+    TEST_ASSERT_TRUE(ring.empty());
+    TEST_ASSERT_FALSE(ring.pop(&e));
+
+    // one slot stays empty
+    for(uint32_t i = 0; i < MIDI_EVENTS_QUEUE_SIZE - 1; i++) TEST_ASSERT_TRUE(ring.push(make_event(i, 0)));
+    TEST_ASSERT_FALSE(ring.push(make_event(0, 0)));
+
+    for(uint32_t i = 0; i < MIDI_EVENTS_QUEUE_SIZE - 1; i++) {
+        TEST_ASSERT_TRUE(ring.pop(&e));
+        TEST_ASSERT_TRUE(check_event(e, i, 0));
+    }
+    TEST_ASSERT_TRUE(ring.empty());
+}
+
+void test_wraparound(void) {
+    static MidiRing ring;
+    TimedMidiEvent e;
+    uint32_t pushed = 0, popped = 0;
+
+    // uneven push and pop counts walk both indices around the ring many times
+    for(int round = 0; round < 1000; round++) {
+        for(int i = 0; i < 7; i++) if(ring.push(make_event(pushed, 1))) pushed++;
+        for(int i = 0; i < 5; i++) if(ring.pop(&e)) TEST_ASSERT_TRUE(check_event(e, popped++, 1));
+    }
+    while(ring.pop(&e)) TEST_ASSERT_TRUE(check_event(e, popped++, 1));
+
+    TEST_ASSERT_EQUAL(pushed, popped);
+}
+
+/** two producer threads, one ring each, and a consumer draining both like i2s_task */
+void test_concurrent_producers(void) {
+    static MidiRing rings[2];
+    const uint32_t COUNT = 1000000;
+
+    std::thread producers[2] = {
+        std::thread(produce, &rings[0], COUNT, 0),
+        std::thread(produce, &rings[1], COUNT, 1),
+    };
+
+    uint32_t next[2] = { 0, 0 };
+    bool in_order = true;
+    TimedMidiEvent e;
+
+    // keeps draining after a mismatch so the producers can finish
+    while(next[0] < COUNT || next[1] < COUNT) {
+        bool got = false;
+        for(uint8_t r = 0; r < 2; r++) {
+            if(!rings[r].pop(&e)) continue;
+            got = true;
+            in_order &= check_event(e, next[r]++, r);
+        }
+        if(!got) std::this_thread::yield();
+    }
+
+    for(auto &t : producers) t.join();
+
+    TEST_ASSERT_TRUE_MESSAGE(in_order, "item lost, torn or out of order");
+    TEST_ASSERT_EQUAL(COUNT, next[0]);
+    TEST_ASSERT_EQUAL(COUNT, next[1]);
+    TEST_ASSERT_TRUE(rings[0].empty() && rings[1].empty());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fill_and_drain);
+    RUN_TEST(test_wraparound);
+    RUN_TEST(test_concurrent_producers);
+    return UNITY_END();
+}
@@ -0,0 +1,191 @@
+#include <unity.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "config.h"
+#include "comms/uart_rx.hpp"
+
+using Bytes = std::vector<uint8_t>;
+
+// ------- RECORDING --------
+/**
+ * what the sender wrote for a short session, framing and escapes included: a log line, four notes on and off
+ * (one of them note 0x7E), a chord and its release as midi batches, a control and a program change,
+ * another log line, an eight step arp and a last log line
+ */
+static const uint8_t SESSION[] = {
+    0x7E, 0x00, 0xF0, 0x73, 0x79, 0x6E, 0x74, 0x68, 0x20, 0x6C, 0x69, 0x6E, 0x6B, 0x20, 0x75, 0x70,
+    0x0A, 0x05, 0xDD, 0x7E, 0x00, 0xA0, 0x09, 0x90, 0x3C, 0x64, 0x71, 0x57, 0x7E, 0x00, 0xA0, 0x09,
+    0x90, 0x40, 0x7D, 0x53, 0xCE, 0xB1, 0x7E, 0x00, 0xA0, 0x09, 0x90, 0x43, 0x7D, 0x54, 0x3D, 0xA9,
+    0x7E, 0x00, 0xA0, 0x09, 0x90, 0x7D, 0x53, 0x7D, 0x54, 0xE7, 0xAF, 0x7E, 0x00, 0xA0, 0x08, 0x80,
+    0x3C, 0x00, 0x7D, 0x54, 0xEB, 0x7E, 0x00, 0xA0, 0x08, 0x80, 0x40, 0x00, 0x19, 0xB2, 0x7E, 0x00,
+    0xA0, 0x08, 0x80, 0x43, 0x00, 0x71, 0x98, 0x7E, 0x00, 0xA0, 0x08, 0x80, 0x7D, 0x53, 0x00, 0xAB,
+    0x9E, 0x7E, 0x00, 0xA1, 0x00, 0x00, 0x09, 0x90, 0x30, 0x64, 0xB0, 0x04, 0x09, 0x90, 0x34, 0x64,
+    0x14, 0x05, 0x09, 0x90, 0x37, 0x64, 0x7D, 0x53, 0x7D, 0x54, 0x09, 0x90, 0x7D, 0x53, 0x64, 0xFD,
+    0xBB, 0x7E, 0x00, 0xA0, 0x0B, 0xB0, 0x4A, 0x7D, 0x53, 0xF3, 0x76, 0x7E, 0x00, 0xA0, 0x0C, 0xC0,
+    0x03, 0x00, 0x8D, 0xAA, 0x7E, 0x00, 0xA1, 0x00, 0x00, 0x08, 0x80, 0x30, 0x00, 0x00, 0x00, 0x08,
+    0x80, 0x34, 0x00, 0x00, 0x00, 0x08, 0x80, 0x37, 0x00, 0x7D, 0x53, 0x7D, 0x54, 0x08, 0x80, 0x7D,
+    0x53, 0x00, 0x56, 0xAD, 0x7E, 0x00, 0xF0, 0x61, 0x72, 0x70, 0x20, 0x31, 0x32, 0x30, 0x62, 0x70,
+    0x6D, 0x20, 0x7D, 0x53, 0x20, 0x64, 0x69, 0x76, 0x20, 0x31, 0x2F, 0x38, 0x20, 0x7B, 0x6F, 0x6B,
+    0x7D, 0x54, 0x0A, 0xA2, 0x37, 0x7E, 0x00, 0xA0, 0x09, 0x90, 0x24, 0x14, 0xA7, 0x7F, 0x7E, 0x00,
+    0xA0, 0x09, 0x90, 0x24, 0x00, 0x02, 0x29, 0x7E, 0x00, 0xA0, 0x09, 0x90, 0x2B, 0x21, 0x41, 0x9A,
+    0x7E, 0x00, 0xA0, 0x09, 0x90, 0x2B, 0x00, 0xCA, 0xAA, 0x7E, 0x00, 0xA0, 0x09, 0x90, 0x32, 0x2E,
+    0x3F, 0x20, 0x7E, 0x00, 0xA0, 0x09, 0x90, 0x32, 0x00, 0x43, 0xE8, 0x7E, 0x00, 0xA0, 0x09, 0x90,
+    0x39, 0x3B, 0xBB, 0x83, 0x7E, 0x00, 0xA0, 0x09, 0x90, 0x39, 0x00, 0xEB, 0x0C, 0x7E, 0x00, 0xA0,
+    0x09, 0x90, 0x40, 0x48, 0x7B, 0xE5, 0x7E, 0x00, 0xA0, 0x09, 0x90, 0x40, 0x00, 0x37, 0x2B, 0x7E,
+    0x00, 0xA0, 0x09, 0x90, 0x47, 0x55, 0x17, 0x63, 0x7E, 0x00, 0xA0, 0x09, 0x90, 0x47, 0x00, 0x3F,
+    0x66, 0x7E, 0x00, 0xA0, 0x09, 0x90, 0x4E, 0x62, 0x33, 0xF1, 0x7E, 0x00, 0xA0, 0x09, 0x90, 0x4E,
+    0x00, 0x27, 0xB1, 0x7E, 0x00, 0xA0, 0x09, 0x90, 0x55, 0x6F, 0xEF, 0x5B, 0x7E, 0x00, 0xA0, 0x09,
+    0x90, 0x55, 0x00, 0x1E, 0xC0, 0x7E, 0x00, 0xF0, 0x62, 0x79, 0x65, 0x0A, 0xCA, 0x60, 0x7E,
+};
+
+static const size_t SESSION_PACKETS = 31;
+
+
+// ------- LOOPBACK --------
+/** plays a recording back like the uart driver: in bursts, read in chunks that may come back short */
+struct Loopback {
+    const uint8_t *stream;
+    size_t len;
+    size_t pos = 0;
+
+    Loopback(const uint8_t *stream, size_t len, size_t start = 0) : stream(stream), len(len), pos(start) {}
+
+    bool done() const { return pos >= len; }
+
+    /** one rx event: up to burst bytes arrive, then rx_task decodes the backlog */
+    void burst(PacketDecoder &decoder, size_t burst, size_t chunk_size, std::vector<Bytes> &out, bool short_reads) {
+        const size_t end = pos + burst < len ? pos + burst : len;
+        uint8_t chunk[UART_RX_BUFFER_SIZE];
+
+        decode_chunks(decoder, chunk, chunk_size, end - pos, [&](uint8_t *buffer, size_t max) {
+            size_t n = end - pos < max ? end - pos : max;
+            if(short_reads && n > 1) n = 1 + rand() % n;
+            memcpy(buffer, stream + pos, n);
+            pos += n;
+            return (int)n;
+        }, [&](const Packet &packet) {
+            Bytes body = { packet.type };
+            body.insert(body.end(), packet.payload, packet.payload + packet.payload_len);
+            out.push_back(body);
+        });
+    }
+
+    /** skips bytes the way an rx overflow loses them, rx_task resets the decoder after it */
+    void drop(size_t bytes) { pos += bytes; }
+};
+
+/** the recording in one go: the reference the other runs compare against */
+static std::vector<Bytes> decode_reference() {
+    PacketDecoder decoder;
+    std::vector<Bytes> packets;
+    Loopback loopback(SESSION, sizeof(SESSION));
+    loopback.burst(decoder, sizeof(SESSION), UART_RX_BUFFER_SIZE, packets, false);
+    return packets;
+}
+
+/** index of every delimiter, frame k of the reference ends at delimiters[k + 1] */
+static std::vector<size_t> delimiters() {
+    std::vector<size_t> out;
+    for(size_t i = 0; i < sizeof(SESSION); i++) if(SESSION[i] == 0x7E) out.push_back(i);
+    return out;
+}
+
+
+// ------- CASES --------
+void setUp(void) { srand(1); }
+void tearDown(void) {}
+
+void test_session_decodes(void) {
+    const auto packets = decode_reference();
+    TEST_ASSERT_EQUAL(SESSION_PACKETS, packets.size());
+    TEST_ASSERT_EQUAL(SESSION_PACKETS + 1, delimiters().size());
+
+    size_t midi = 0, batches = 0, logs = 0;
+    for(const auto &p : packets) {
+        midi    += p[0] == 0xA0 && p.size() == 1 + 4;
+        batches += p[0] == 0xA1 && p.size() == 1 + 4 * 6;
+        logs    += p[0] == 0xF0 && p.back() == '\n';
+    }
+    TEST_ASSERT_EQUAL(26, midi);
+    TEST_ASSERT_EQUAL(2, batches);
+    TEST_ASSERT_EQUAL(3, logs);
+
+    // escaped bytes come back as they were sent
+    const Bytes note_7e = { 0xA0, 0x09, 0x90, 0x7E, 0x7D };
+    TEST_ASSERT_TRUE(packets[4] == note_7e);
+}
+
+void test_random_bursts(void) {
+    const auto reference = decode_reference();
+
+    for(int run = 0; run < 2000; run++) {
+        PacketDecoder decoder;
+        std::vector<Bytes> packets;
+        Loopback loopback(SESSION, sizeof(SESSION));
+        const size_t chunk_size = 1 + rand() % UART_RX_BUFFER_SIZE;
+        const bool short_reads = run % 2;
+
+        while(!loopback.done()) loopback.burst(decoder, 1 + rand() % 160, chunk_size, packets, short_reads);
+
+        TEST_ASSERT_EQUAL(reference.size(), packets.size());
+        TEST_ASSERT_TRUE_MESSAGE(packets == reference, "chunking changed the decoded packets");
+    }
+}
+
+/** booting in the middle of the stream: the partial frame is dropped, every whole one after it decodes */
+void test_start_mid_stream(void) {
+    const auto reference = decode_reference();
+    const auto delims = delimiters();
+
+    for(size_t start = 1; start < sizeof(SESSION); start++) {
+        PacketDecoder decoder;
+        std::vector<Bytes> packets;
+        Loopback loopback(SESSION, sizeof(SESSION), start);
+        while(!loopback.done()) loopback.burst(decoder, 1 + rand() % 64, UART_RX_BUFFER_SIZE, packets, false);
+
+        size_t first = 0;
+        while(first < reference.size() && delims[first] + 1 < start) first++;
+
+        const std::vector<Bytes> expected(reference.begin() + first, reference.end());
+        TEST_ASSERT_TRUE_MESSAGE(packets == expected, "wrong packets after a mid stream start");
+    }
+}
+
+/** an rx overflow loses a run of bytes and resets the decoder: frames on either side survive */
+void test_overflow_resync(void) {
+    const auto reference = decode_reference();
+    const auto delims = delimiters();
+
+    for(int run = 0; run < 2000; run++) {
+        const size_t drop_at  = 1 + rand() % (sizeof(SESSION) - 1);
+        const size_t drop_len = 1 + rand() % 48;
+
+        PacketDecoder decoder;
+        std::vector<Bytes> packets;
+        Loopback loopback(SESSION, drop_at);
+        while(!loopback.done()) loopback.burst(decoder, 1 + rand() % 64, UART_RX_BUFFER_SIZE, packets, false);
+
+        loopback = Loopback(SESSION, sizeof(SESSION), drop_at + drop_len);
+        decoder.reset();
+        while(!loopback.done()) loopback.burst(decoder, 1 + rand() % 64, UART_RX_BUFFER_SIZE, packets, false);
+
+        std::vector<Bytes> expected;
+        for(size_t k = 0; k < reference.size(); k++) {
+            const bool before = delims[k + 1] < drop_at;
+            const bool after  = delims[k] + 1 >= drop_at + drop_len;
+            if(before || after) expected.push_back(reference[k]);
+        }
+        TEST_ASSERT_TRUE_MESSAGE(packets == expected, "wrong packets around an rx overflow");
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_session_decodes);
+    RUN_TEST(test_random_bursts);
+    RUN_TEST(test_start_mid_stream);
+    RUN_TEST(test_overflow_resync);
+    return UNITY_END();
+}
@@ -0,0 +1,202 @@
+#include <unity.h>
+#include <cmath>
+#include <cstring>
+#include "input/Btn.hpp"
+#include "ui/UiController.hpp"
+#include "ui/widget.hpp"
+
+static const KnobConfig linear_config = { -1.f, 1.f,     Curve::Linear, format_pan, 0.f };
+static const KnobConfig log_config    = { 20.f, 20000.f, Curve::Log,    format_hz,  1000.f };
+
+static float last_value;
+static int callbacks;
+
+static void on_change(float value, void *ctx) {
+    last_value = value;
+    callbacks++;
+}
+
+static InputEvent turn(int16_t value, InputId id = InputId::Encoder0, bool shifted = false) {
+    InputEvent event;
+    event.id = id;
+    event.value = value;
+    event.shifed = shifted;
+    return event;
+}
+
+
+// ------- CASES --------
+void setUp(void) {
+    callbacks = 0;
+}
+
+void tearDown(void) {}
+
+void test_knob_linear_ends_and_middle(void) {
+    // 1023 steps have no exact middle, the default lands on the nearest one
+    const float step = 2.f / (Knob::RESOLUTION - 1);
+    Knob knob("pan", linear_config);
+    TEST_ASSERT_FLOAT_WITHIN(step, 0.f, knob.get_value());
+
+    knob.set_raw(0);
+    TEST_ASSERT_EQUAL_FLOAT(-1.f, knob.get_value());
+    knob.set_raw(Knob::RESOLUTION - 1);
+    TEST_ASSERT_EQUAL_FLOAT(1.f, knob.get_value());
+
+    // equal steps over the whole range
+    for(int32_t pos = 1; pos < Knob::RESOLUTION; pos++) {
+        knob.set_raw(pos - 1);
+        const float before = knob.get_value();
+        knob.set_raw(pos);
+        TEST_ASSERT_FLOAT_WITHIN(1e-5f, step, knob.get_value() - before);
+    }
+}
+
+/** log: equal ratio per step, the middle position is the geometric mean */
+void test_knob_log_ratio(void) {
+    Knob knob("cut", log_config);
+
+    knob.set_raw(0);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 20.f, knob.get_value());
+    knob.set_raw(Knob::RESOLUTION - 1);
+    TEST_ASSERT_FLOAT_WITHIN(1e-1f, 20000.f, knob.get_value());
+
+    const float ratio = powf(1000.f, 1.f / (Knob::RESOLUTION - 1));
+    for(int32_t pos = 1; pos < Knob::RESOLUTION; pos++) {
+        knob.set_raw(pos - 1);
+        const float before = knob.get_value();
+        knob.set_raw(pos);
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, ratio, knob.get_value() / before);
+    }
+
+    knob.set_value(sqrtf(20.f * 20000.f));
+    TEST_ASSERT_INT_WITHIN(1, (Knob::RESOLUTION - 1) / 2, knob.get_raw());
+}
+
+/** all 1024 positions are distinct values and set_value finds its way back to each of them */
+void test_knob_resolution_roundtrip(void) {
+    const KnobConfig *configs[] = { &linear_config, &log_config };
+
+    for(const KnobConfig *config : configs) {
+        Knob knob("k", *config);
+        float previous = -INFINITY;
+
+        for(int32_t pos = 0; pos < Knob::RESOLUTION; pos++) {
+            knob.set_raw(pos);
+            const float value = knob.get_value();
+            TEST_ASSERT_TRUE(value > previous);
+            previous = value;
+
+            knob.set_value(value);
+            TEST_ASSERT_EQUAL(pos, knob.get_raw());
+        }
+    }
+}
+
+void test_knob_clamps(void) {
+    Knob knob("cut", log_config);
+
+    knob.set_value(1.f);
+    TEST_ASSERT_EQUAL(0, knob.get_raw());
+    knob.set_value(1e6f);
+    TEST_ASSERT_EQUAL(Knob::RESOLUTION - 1, knob.get_raw());
+
+    knob.set_raw(-5);
+    TEST_ASSERT_EQUAL(0, knob.get_raw());
+    knob.set_raw(5000);
+    TEST_ASSERT_EQUAL(Knob::RESOLUTION - 1, knob.get_raw());
+    TEST_ASSERT_EQUAL(Knob::RESOLUTION - 1, knob.get_raw_max());
+}
+
+/** an encoder step moves DETENT_STEP positions, accelerated steps multiply it, the ends stop it */
+void test_knob_detents(void) {
+    Knob knob("pan", linear_config);
+    knob.cb = on_change;
+    knob.set_raw(500);
+    callbacks = 0;
+    knob.dirty = false;
+
+    knob.process_event(turn(1));
+    TEST_ASSERT_EQUAL(500 + Knob::DETENT_STEP, knob.get_raw());
+    TEST_ASSERT_TRUE(knob.dirty);
+    TEST_ASSERT_EQUAL(1, callbacks);
+    TEST_ASSERT_EQUAL_FLOAT(knob.get_value(), last_value);
+
+    knob.process_event(turn(-8));
+    TEST_ASSERT_EQUAL(500 - 7 * Knob::DETENT_STEP, knob.get_raw());
+
+    // a full turn from either end takes RESOLUTION / DETENT_STEP detents
+    knob.set_raw(0);
+    for(int i = 0; i < Knob::RESOLUTION / Knob::DETENT_STEP - 1; i++) knob.process_event(turn(1));
+    TEST_ASSERT_EQUAL(Knob::RESOLUTION - Knob::DETENT_STEP, knob.get_raw());
+    knob.process_event(turn(1));
+    TEST_ASSERT_EQUAL(Knob::RESOLUTION - 1, knob.get_raw());
+
+    // no move at the end: no callback, nothing to redraw
+    callbacks = 0;
+    knob.dirty = false;
+    knob.process_event(turn(3));
+    TEST_ASSERT_EQUAL(0, callbacks);
+    TEST_ASSERT_FALSE(knob.dirty);
+}
+
+void test_knob_formats(void) {
+    char text[8];
+    format_hz(text, sizeof(text), 440.f);
+    TEST_ASSERT_EQUAL_STRING("440", text);
+    format_hz(text, sizeof(text), 12500.f);
+    TEST_ASSERT_EQUAL_STRING("12.5k", text);
+    format_secs(text, sizeof(text), 0.25f);
+    TEST_ASSERT_EQUAL_STRING("0.25s", text);
+    format_pan(text, sizeof(text), -0.5f);
+    TEST_ASSERT_EQUAL_STRING("L50", text);
+    format_pan(text, sizeof(text), 0.f);
+    TEST_ASSERT_EQUAL_STRING("C", text);
+    format_cents(text, sizeof(text), 7.f);
+    TEST_ASSERT_EQUAL_STRING("+7", text);
+}
+
+/** a partial redraw of the right column must leave the screen as a full redraw of the same state would */
+void test_partial_redraw_keeps_layer_indicator(void) {
+    static Adafruit_SSD1306 display(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    static UiController ui(&display);
+    static uint8_t partial[SCREEN_BUFFER_SIZE];
+    DirtyRegion region;
+
+    ui.init();
+    for(int layer = 0; layer < 2; layer++) {
+        ui.process_event(turn(layer ? BtnEvent::Press : BtnEvent::Release, InputId::BtnShift));
+        ui.render_to_buffer(region);
+
+        region = DirtyRegion();
+        // osc1: shape selector on the first row, the enabled switch (on) on the shifted one
+        ui.process_event(turn(layer ? -1 : 1, InputId::Encoder2, layer));
+        TEST_ASSERT_TRUE(ui.render_to_buffer(region));
+        TEST_ASSERT_EQUAL(DISPLAY_WIDTH - 1, region.col_end);
+
+        const int16_t y0 = layer ? 17 : 45;
+        for(int i = 0; i < 4; i++)
+            for(int16_t y = y0 + i * 5; y < y0 + i * 5 + 3; y++)
+                TEST_ASSERT_TRUE(display.getPixel(DISPLAY_WIDTH - 2, y));
+
+        // away and back forces the full redraw
+        memcpy(partial, display.getBuffer(), sizeof(partial));
+        ui.process_event(turn(BtnEvent::Press, InputId::BtnRx));
+        ui.render_to_buffer(region);
+        ui.process_event(turn(BtnEvent::Press, InputId::BtnLx));
+        ui.render_to_buffer(region);
+        TEST_ASSERT_EQUAL_MEMORY(display.getBuffer(), partial, sizeof(partial));
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_knob_linear_ends_and_middle);
+    RUN_TEST(test_knob_log_ratio);
+    RUN_TEST(test_knob_resolution_roundtrip);
+    RUN_TEST(test_knob_clamps);
+    RUN_TEST(test_knob_detents);
+    RUN_TEST(test_knob_formats);
+    RUN_TEST(test_partial_redraw_keeps_layer_indicator);
+    return UNITY_END();
+}